@@ -11,73 +11,97 @@
 #define LEMON_SUPPORT_TRACING 1
 #endif
 
+/* AST nodes are tiny, so grab memory for them in big chunks. */
+#define AST_ARENA_CHUNK_SIZE (64 * 1024)
 
-/* These functions are mostly for construction and cleanup of nodes in the
-   parse tree. Mostly this is simple allocation and initialization, so we
-   can do as little in the lemon code as possible, and then sort it all out
-   afterwards. */
 
-#define NEW_AST_NODE(retval, cls, typ) \
-    cls *retval = (cls *) Malloc(ctx, sizeof (cls)); \
+/* These functions are mostly for construction of nodes in the parse tree.
+   Mostly this is simple allocation and initialization, so we can do as
+   little in the lemon code as possible, and then sort it all out afterwards.
+
+   All nodes come out of ctx->ast_arena, so there's no per-node cleanup:
+   ast_end() throws away the whole tree at once by destroying the arena.
+   This also means the parser doesn't need destructors for error recovery;
+   anything it drops on the floor goes away with the arena, too. */
+
+/* ctx->filename points into the preprocessor's filename cache, which goes
+   away before semantic analysis, so nodes get a copy from the AST's own
+   string cache instead. Nodes mostly come in runs from the same file, so
+   this only does real work when the filename changes. */
+static const char *ast_filename(Context *ctx)
+{
+    if (ctx->filename != ctx->ast_filename_source) {
+        ctx->ast_filename_source = ctx->filename;
+        ctx->ast_filename = ctx->filename ? stringcache(ctx->strcache, ctx->filename) : NULL;
+    }
+    return ctx->ast_filename;
+}
+
+#define NEW_AST_NODE(retval, cls, typ, where) \
+    cls *retval = (cls *) arena_alloc(ctx->ast_arena, sizeof (cls)); \
     do { \
         if (retval == NULL) { return NULL; } \
         retval->ast.type = typ; \
-        retval->ast.filename = ctx->filename; \
-        retval->ast.line = ctx->position; \
+        retval->ast.filename = (where).filename; \
+        retval->ast.line = (where).line; \
+        retval->ast.position = (where).position; \
         retval->ast.dt = NULL; \
     } while (0)
 
-#define DELETE_AST_NODE(cls) do { \
-    if (!cls) return; \
-} while (0)
-
 #define NEW_AST_LIST(retval, cls, first) \
-    cls *retval = (cls *) Malloc(ctx, sizeof (cls)); \
+    cls *retval = (cls *) arena_alloc(ctx->ast_arena, sizeof (cls)); \
     do { \
         if (retval == NULL) { return NULL; } \
         retval->head = retval->tail = first; \
     } while (0)
 
-#define DELETE_AST_LIST(list, listedcls, deletefn) do { \
-    listedcls *i; \
-    listedcls *next; \
-    if (!list) return; \
-    for (i = list->head; i != NULL; i = next) { \
-        next = i->next; \
-        i->next = NULL; \
-        deletefn(ctx, i); \
-    } \
-    Free(ctx, list); \
-} while (0)
-
-#define NEW_AST_STATEMENT_NODE(retval, cls, typ) \
-    NEW_AST_NODE(retval, cls, typ); \
+#define NEW_AST_STATEMENT_NODE(retval, cls, typ, where) \
+    NEW_AST_NODE(retval, cls, typ, where); \
     retval->next = NULL;
 
-#define DELETE_AST_STATEMENT_NODE(stmt) do { \
-    DELETE_AST_NODE(stmt); \
-    delete_statement(ctx, stmt->next); \
-} while (0)
 
+/* Where a token came from. The parser only reduces a rule once it has seen
+   the token after it, so nodes can't just use the preprocessor's current
+   position; they're placed at the first token of the rule that made them. */
+typedef struct AstLocation
+{
+    const char *filename;  /* strcache'd */
+    Sint32 line;
+    size_t position;
+} AstLocation;
 
-typedef union TokenData
+typedef struct TokenData
 {
-    Sint64 i64;
-    double dbl;
-    const char *string;
+    AstLocation where;
+    union
+    {
+        Sint64 i64;
+        double dbl;
+        const char *string;
+    } value;
 } TokenData;
 
+/* where the first token of an existing node was, for rules that start with one. */
+static AstLocation node_location(const void *node)
+{
+    const SDL_SHADER_AstGeneric *generic = (const SDL_SHADER_AstGeneric *) node;
+    AstLocation retval;
+    if (generic != NULL) {
+        retval.filename = generic->ast.filename;
+        retval.line = (Sint32) generic->ast.line;
+        retval.position = generic->ast.position;
+    } else {  /* ran out of memory making it; the parse is failing anyhow. */
+        SDL_zero(retval);
+    }
+    return retval;
+}
 
-// these functions create and delete AST nodes, moving the work out of the lemon parser code.
 
-static void delete_expression(Context *ctx, SDL_SHADER_AstExpression *expr);
-static void delete_statement(Context *ctx, SDL_SHADER_AstStatement *stmt);
-static void delete_assignment_statement(Context *ctx, SDL_SHADER_AstAssignStatement *asstmt);  /* !!! FIXME: stupid for-loop! */
-static void delete_translation_unit(Context *ctx, SDL_SHADER_AstTranslationUnit *unit);
+// these functions create AST nodes, moving the work out of the lemon parser code.
 
-static SDL_SHADER_AstAtAttribute *new_at_attribute(Context *ctx, const char *name, const Sint64 *argument)
+static SDL_SHADER_AstAtAttribute *new_at_attribute(Context *ctx, const AstLocation where, const char *name, const Sint64 *argument)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstAtAttribute, SDL_SHADER_AST_AT_ATTRIBUTE);
+    NEW_AST_NODE(retval, SDL_SHADER_AstAtAttribute, SDL_SHADER_AST_AT_ATTRIBUTE, where);
     retval->name = name;  /* strcache'd */
     if (argument != NULL) {
         retval->has_argument = SDL_TRUE;
@@ -89,67 +113,37 @@ static SDL_SHADER_AstAtAttribute *new_at_attribute(Context *ctx, const char *nam
     return retval;
 }
 
-static void delete_at_attribute(Context *ctx, SDL_SHADER_AstAtAttribute *atattr)
+static SDL_SHADER_AstExpression *new_identifier_expression(Context *ctx, const AstLocation where, const char *name)
 {
-    DELETE_AST_NODE(atattr);
-    Free(ctx, atattr);
-}
-
-static SDL_SHADER_AstExpression *new_identifier_expression(Context *ctx, const char *name)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstIdentifierExpression, SDL_SHADER_AST_OP_IDENTIFIER);
+    NEW_AST_NODE(retval, SDL_SHADER_AstIdentifierExpression, SDL_SHADER_AST_OP_IDENTIFIER, where);
     retval->name = name;  /* strcache'd */
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_identifier_expression(Context *ctx, SDL_SHADER_AstIdentifierExpression *expr)
+static SDL_SHADER_AstExpression *new_int_expression(Context *ctx, const AstLocation where, Sint64 value)
 {
-    DELETE_AST_NODE(expr);
-    Free(ctx, expr);
-}
-
-static SDL_SHADER_AstExpression *new_int_expression(Context *ctx, Sint64 value)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstIntLiteralExpression, SDL_SHADER_AST_OP_INT_LITERAL);
+    NEW_AST_NODE(retval, SDL_SHADER_AstIntLiteralExpression, SDL_SHADER_AST_OP_INT_LITERAL, where);
     retval->value = value;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_int_expression(Context *ctx, SDL_SHADER_AstIntLiteralExpression *expr)
-{
-    DELETE_AST_NODE(expr);
-    Free(ctx, expr);
-}
-
-static SDL_SHADER_AstExpression *new_float_expression(Context *ctx, double value)
+static SDL_SHADER_AstExpression *new_float_expression(Context *ctx, const AstLocation where, double value)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstFloatLiteralExpression, SDL_SHADER_AST_OP_FLOAT_LITERAL);
+    NEW_AST_NODE(retval, SDL_SHADER_AstFloatLiteralExpression, SDL_SHADER_AST_OP_FLOAT_LITERAL, where);
     retval->value = value;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_float_expression(Context *ctx, SDL_SHADER_AstFloatLiteralExpression *expr)
+static SDL_SHADER_AstExpression *new_bool_expression(Context *ctx, const AstLocation where, int value)
 {
-    DELETE_AST_NODE(expr);
-    Free(ctx, expr);
-}
-
-static SDL_SHADER_AstExpression *new_bool_expression(Context *ctx, int value)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstBooleanLiteralExpression, SDL_SHADER_AST_OP_BOOLEAN_LITERAL);
+    NEW_AST_NODE(retval, SDL_SHADER_AstBooleanLiteralExpression, SDL_SHADER_AST_OP_BOOLEAN_LITERAL, where);
     retval->value = value ? SDL_TRUE : SDL_FALSE;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_bool_expression(Context *ctx, SDL_SHADER_AstBooleanLiteralExpression *expr)
-{
-    DELETE_AST_NODE(expr);
-    Free(ctx, expr);
-}
-
 static SDL_SHADER_AstArgument *new_argument(Context *ctx, SDL_SHADER_AstExpression *arg)
 {
-    SDL_SHADER_AstArgument *retval = (SDL_SHADER_AstArgument *) Malloc(ctx, sizeof (SDL_SHADER_AstArgument));
+    SDL_SHADER_AstArgument *retval = (SDL_SHADER_AstArgument *) arena_alloc(ctx->ast_arena, sizeof (SDL_SHADER_AstArgument));
     if (retval) {
         retval->arg = arg;
         retval->next = NULL;
@@ -157,271 +151,138 @@ static SDL_SHADER_AstArgument *new_argument(Context *ctx, SDL_SHADER_AstExpressi
     return retval;
 }
 
-static void delete_argument(Context *ctx, SDL_SHADER_AstArgument *arg)
-{
-    if (arg) {
-        delete_expression(ctx, arg->arg);
-        delete_argument(ctx, arg->next);
-        Free(ctx, arg);
-    }
-}
-
 static SDL_SHADER_AstArguments *new_arguments(Context *ctx, SDL_SHADER_AstArgument *first)
 {
     NEW_AST_LIST(retval, SDL_SHADER_AstArguments, first);
     return retval;
 }
 
-static void delete_arguments(Context *ctx, SDL_SHADER_AstArguments *arguments)
+static SDL_SHADER_AstExpression *new_fncall_expression(Context *ctx, const AstLocation where, const char *fnname, SDL_SHADER_AstArguments *arguments)
 {
-    DELETE_AST_LIST(arguments, SDL_SHADER_AstArgument, delete_argument);
-}
-
-static SDL_SHADER_AstExpression *new_fncall_expression(Context *ctx, const char *fnname, SDL_SHADER_AstArguments *arguments)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstFunctionCallExpression, SDL_SHADER_AST_OP_CALLFUNC);
+    NEW_AST_NODE(retval, SDL_SHADER_AstFunctionCallExpression, SDL_SHADER_AST_OP_CALLFUNC, where);
     retval->fnname = fnname;  /* strcache'd */
     retval->arguments = arguments;
     retval->fn = NULL;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_fncall_expression(Context *ctx, SDL_SHADER_AstFunctionCallExpression *expr)
+static SDL_SHADER_AstExpression *new_unary_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *operand)
 {
-    DELETE_AST_NODE(expr);
-    delete_arguments(ctx, expr->arguments);
-    Free(ctx, expr);
-}
-
-static SDL_SHADER_AstExpression *new_unary_expression(Context *ctx, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *operand)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstUnaryExpression, asttype);
+    NEW_AST_NODE(retval, SDL_SHADER_AstUnaryExpression, asttype, where);
     retval->operand = operand;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_unary_expression(Context *ctx, SDL_SHADER_AstUnaryExpression *expr)
-{
-    DELETE_AST_NODE(expr);
-    delete_expression(ctx, expr->operand);
-    Free(ctx, expr);
-}
-
-static SDL_SHADER_AstExpression *new_unaryminus_expression(Context *ctx, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, SDL_SHADER_AST_OP_NEGATE, operand); }
-static SDL_SHADER_AstExpression *new_unaryplus_expression(Context *ctx, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, SDL_SHADER_AST_OP_POSITIVE, operand); }
-static SDL_SHADER_AstExpression *new_unarycompl_expression(Context *ctx, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, SDL_SHADER_AST_OP_COMPLEMENT, operand); }
-static SDL_SHADER_AstExpression *new_unarynot_expression(Context *ctx, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, SDL_SHADER_AST_OP_NOT, operand); }
-static SDL_SHADER_AstExpression *new_parentheses_expression(Context *ctx, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, SDL_SHADER_AST_OP_PARENTHESES, operand); }
+static SDL_SHADER_AstExpression *new_unaryminus_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, where, SDL_SHADER_AST_OP_NEGATE, operand); }
+static SDL_SHADER_AstExpression *new_unaryplus_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, where, SDL_SHADER_AST_OP_POSITIVE, operand); }
+static SDL_SHADER_AstExpression *new_unarycompl_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, where, SDL_SHADER_AST_OP_COMPLEMENT, operand); }
+static SDL_SHADER_AstExpression *new_unarynot_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, where, SDL_SHADER_AST_OP_NOT, operand); }
+static SDL_SHADER_AstExpression *new_parentheses_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *operand) { return new_unary_expression(ctx, where, SDL_SHADER_AST_OP_PARENTHESES, operand); }
 
-static SDL_SHADER_AstExpression *new_binary_expression(Context *ctx, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right)
+static SDL_SHADER_AstExpression *new_binary_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstBinaryExpression, asttype);
+    NEW_AST_NODE(retval, SDL_SHADER_AstBinaryExpression, asttype, where);
     retval->left = left;
     retval->right = right;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_binary_expression(Context *ctx, SDL_SHADER_AstBinaryExpression *expr)
-{
-    DELETE_AST_NODE(expr);
-    delete_expression(ctx, expr->left);
-    delete_expression(ctx, expr->right);
-    Free(ctx, expr);
-}
-
-static SDL_SHADER_AstExpression *new_multiply_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_MULTIPLY, left, right); }
-static SDL_SHADER_AstExpression *new_divide_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_DIVIDE, left, right); }
-static SDL_SHADER_AstExpression *new_mod_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_MODULO, left, right); }
-static SDL_SHADER_AstExpression *new_addition_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_ADD, left, right); }
-static SDL_SHADER_AstExpression *new_subtraction_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_SUBTRACT, left, right); }
-static SDL_SHADER_AstExpression *new_lshift_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_LSHIFT, left, right); }
-static SDL_SHADER_AstExpression *new_rshift_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_RSHIFT, left, right); }
-static SDL_SHADER_AstExpression *new_lt_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_LESSTHAN, left, right); }
-static SDL_SHADER_AstExpression *new_gt_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_GREATERTHAN, left, right); }
-static SDL_SHADER_AstExpression *new_leq_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_LESSTHANOREQUAL, left, right); }
-static SDL_SHADER_AstExpression *new_geq_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_GREATERTHANOREQUAL, left, right); }
-static SDL_SHADER_AstExpression *new_eql_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_EQUAL, left, right); }
-static SDL_SHADER_AstExpression *new_neq_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_NOTEQUAL, left, right); }
-static SDL_SHADER_AstExpression *new_and_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_BINARYAND, left, right); }
-static SDL_SHADER_AstExpression *new_xor_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_BINARYXOR, left, right); }
-static SDL_SHADER_AstExpression *new_or_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_BINARYOR, left, right); }
-static SDL_SHADER_AstExpression *new_andand_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_LOGICALAND, left, right); }
-static SDL_SHADER_AstExpression *new_oror_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_LOGICALOR, left, right); }
-static SDL_SHADER_AstExpression *new_array_dereference_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, SDL_SHADER_AST_OP_DEREF_ARRAY, left, right); }
-static SDL_SHADER_AstExpression *new_ternary_expression(Context *ctx, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *center, SDL_SHADER_AstExpression *right)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstTernaryExpression, asttype);
+static SDL_SHADER_AstExpression *new_multiply_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_MULTIPLY, left, right); }
+static SDL_SHADER_AstExpression *new_divide_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_DIVIDE, left, right); }
+static SDL_SHADER_AstExpression *new_mod_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_MODULO, left, right); }
+static SDL_SHADER_AstExpression *new_addition_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_ADD, left, right); }
+static SDL_SHADER_AstExpression *new_subtraction_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_SUBTRACT, left, right); }
+static SDL_SHADER_AstExpression *new_lshift_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_LSHIFT, left, right); }
+static SDL_SHADER_AstExpression *new_rshift_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_RSHIFT, left, right); }
+static SDL_SHADER_AstExpression *new_lt_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_LESSTHAN, left, right); }
+static SDL_SHADER_AstExpression *new_gt_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_GREATERTHAN, left, right); }
+static SDL_SHADER_AstExpression *new_leq_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_LESSTHANOREQUAL, left, right); }
+static SDL_SHADER_AstExpression *new_geq_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_GREATERTHANOREQUAL, left, right); }
+static SDL_SHADER_AstExpression *new_eql_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_EQUAL, left, right); }
+static SDL_SHADER_AstExpression *new_neq_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_NOTEQUAL, left, right); }
+static SDL_SHADER_AstExpression *new_and_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_BINARYAND, left, right); }
+static SDL_SHADER_AstExpression *new_xor_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_BINARYXOR, left, right); }
+static SDL_SHADER_AstExpression *new_or_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_BINARYOR, left, right); }
+static SDL_SHADER_AstExpression *new_andand_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_LOGICALAND, left, right); }
+static SDL_SHADER_AstExpression *new_oror_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_LOGICALOR, left, right); }
+static SDL_SHADER_AstExpression *new_array_dereference_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *right) { return new_binary_expression(ctx, where, SDL_SHADER_AST_OP_DEREF_ARRAY, left, right); }
+static SDL_SHADER_AstExpression *new_ternary_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *center, SDL_SHADER_AstExpression *right)
+{
+    NEW_AST_NODE(retval, SDL_SHADER_AstTernaryExpression, asttype, where);
     retval->left = left;
     retval->center = center;
     retval->right = right;
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_ternary_expression(Context *ctx, SDL_SHADER_AstTernaryExpression *expr)
-{
-    DELETE_AST_NODE(expr);
-    delete_expression(ctx, expr->left);
-    delete_expression(ctx, expr->center);
-    delete_expression(ctx, expr->right);
-    Free(ctx, expr);
-}
+static SDL_SHADER_AstExpression *new_conditional_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *center, SDL_SHADER_AstExpression *right) { return new_ternary_expression(ctx, where, SDL_SHADER_AST_OP_CONDITIONAL, left, center, right); }
 
-static SDL_SHADER_AstExpression *new_conditional_expression(Context *ctx, SDL_SHADER_AstExpression *left, SDL_SHADER_AstExpression *center, SDL_SHADER_AstExpression *right) { return new_ternary_expression(ctx, SDL_SHADER_AST_OP_CONDITIONAL, left, center, right); }
-
-static SDL_SHADER_AstExpression *new_struct_dereference_expression(Context *ctx, SDL_SHADER_AstExpression *expr, const char *field)
+static SDL_SHADER_AstExpression *new_struct_dereference_expression(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *expr, const char *field)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstStructDerefExpression, SDL_SHADER_AST_OP_DEREF_STRUCT);
+    NEW_AST_NODE(retval, SDL_SHADER_AstStructDerefExpression, SDL_SHADER_AST_OP_DEREF_STRUCT, where);
     retval->expr = expr;
     retval->field = field;  /* strcache'd */
     return (SDL_SHADER_AstExpression *) retval;
 }
 
-static void delete_struct_dereference_expression(Context *ctx, SDL_SHADER_AstStructDerefExpression *expr)
-{
-    DELETE_AST_NODE(expr);
-    delete_expression(ctx, expr->expr);
-    Free(ctx, expr);
-}
-
-static void delete_expression(Context *ctx, SDL_SHADER_AstExpression *expr)
+static SDL_SHADER_AstStatement *new_simple_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstNodeType asttype)
 {
-    SDL_SHADER_AstNode *ast = (SDL_SHADER_AstNode *) expr;
-    if (!ast) {
-        return;
-    } else if (operator_is_binary(ast->ast.type)) {
-        delete_binary_expression(ctx, &ast->binary);
-    } else if (operator_is_unary(ast->ast.type)) {
-        delete_unary_expression(ctx, &ast->unary);
-    } else if (operator_is_ternary(ast->ast.type)) {
-        delete_ternary_expression(ctx, &ast->ternary);
-    } else {
-        switch (ast->ast.type) {
-            case SDL_SHADER_AST_OP_IDENTIFIER: delete_identifier_expression(ctx, &ast->identifier); return;
-            case SDL_SHADER_AST_OP_INT_LITERAL: delete_int_expression(ctx, &ast->intliteral); return;
-            case SDL_SHADER_AST_OP_FLOAT_LITERAL: delete_float_expression(ctx, &ast->floatliteral); return;
-            case SDL_SHADER_AST_OP_BOOLEAN_LITERAL: delete_bool_expression(ctx, &ast->boolliteral); return;
-            case SDL_SHADER_AST_OP_CALLFUNC: delete_fncall_expression(ctx, &ast->fncall); return;
-            case SDL_SHADER_AST_OP_DEREF_STRUCT: delete_struct_dereference_expression(ctx, &ast->structderef); return;
-            default: break;
-        }
-        SDL_assert(!"Unexpected statement type");
-    }
-}
-
-static SDL_SHADER_AstStatement *new_simple_statement(Context *ctx, SDL_SHADER_AstNodeType asttype)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstSimpleStatement, asttype);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstSimpleStatement, asttype, where);
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_simple_statement(Context *ctx, SDL_SHADER_AstSimpleStatement *simple)
-{
-    DELETE_AST_STATEMENT_NODE(simple);
-    delete_statement(ctx, simple->next);
-    Free(ctx, simple);
-}
+static SDL_SHADER_AstStatement *new_empty_statement(Context *ctx, const AstLocation where) { return new_simple_statement(ctx, where, SDL_SHADER_AST_STATEMENT_EMPTY); }
+static SDL_SHADER_AstStatement *new_discard_statement(Context *ctx, const AstLocation where) { return new_simple_statement(ctx, where, SDL_SHADER_AST_STATEMENT_DISCARD); }
 
-static SDL_SHADER_AstStatement *new_empty_statement(Context *ctx) { return new_simple_statement(ctx, SDL_SHADER_AST_STATEMENT_EMPTY); }
-static SDL_SHADER_AstStatement *new_discard_statement(Context *ctx) { return new_simple_statement(ctx, SDL_SHADER_AST_STATEMENT_DISCARD); }
-
-static SDL_SHADER_AstStatement *new_break_statement(Context *ctx)
+static SDL_SHADER_AstStatement *new_break_statement(Context *ctx, const AstLocation where)
 {
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstBreakStatement, SDL_SHADER_AST_STATEMENT_BREAK);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstBreakStatement, SDL_SHADER_AST_STATEMENT_BREAK, where);
     retval->parent = NULL;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_break_statement(Context *ctx, SDL_SHADER_AstBreakStatement *brstmt)
-{
-    DELETE_AST_STATEMENT_NODE(brstmt);
-    delete_statement(ctx, brstmt->next);
-    /* don't delete parent; it's not allocated by us */
-    Free(ctx, brstmt);
-}
-
-static SDL_SHADER_AstStatement *new_continue_statement(Context *ctx)
+static SDL_SHADER_AstStatement *new_continue_statement(Context *ctx, const AstLocation where)
 {
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstContinueStatement, SDL_SHADER_AST_STATEMENT_CONTINUE);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstContinueStatement, SDL_SHADER_AST_STATEMENT_CONTINUE, where);
     retval->parent = NULL;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_continue_statement(Context *ctx, SDL_SHADER_AstContinueStatement *contstmt)
-{
-    DELETE_AST_STATEMENT_NODE(contstmt);
-    delete_statement(ctx, contstmt->next);
-    /* don't delete parent; it's not allocated by us */
-    Free(ctx, contstmt);
-}
-
-static SDL_SHADER_AstVarDeclaration *new_var_declaration(Context *ctx, const char *datatype_name, const char *name, SDL_SHADER_AstExpression *initializer)
+static SDL_SHADER_AstVarDeclaration *new_var_declaration(Context *ctx, const AstLocation where, const char *datatype_name, const char *name, SDL_SHADER_AstExpression *initializer)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstVarDeclaration, SDL_SHADER_AST_VARIABLE_DECLARATION);
+    NEW_AST_NODE(retval, SDL_SHADER_AstVarDeclaration, SDL_SHADER_AST_VARIABLE_DECLARATION, where);
     retval->datatype_name = datatype_name;  /* strcache'd */
     retval->name = name; /* strcache'd */
     retval->initializer = initializer;
     return retval;
 }
 
-static void delete_var_declaration(Context *ctx, SDL_SHADER_AstVarDeclaration *vardecl)
+static SDL_SHADER_AstStatement *new_var_declaration_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstVarDeclaration *vardecl)
 {
-    DELETE_AST_NODE(vardecl);
-    delete_expression(ctx, vardecl->initializer);
-    Free(ctx, vardecl);
-}
-
-static SDL_SHADER_AstStatement *new_var_declaration_statement(Context *ctx, SDL_SHADER_AstVarDeclaration *vardecl)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstVarDeclStatement, SDL_SHADER_AST_STATEMENT_VARDECL);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstVarDeclStatement, SDL_SHADER_AST_STATEMENT_VARDECL, where);
     retval->vardecl = vardecl;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_var_declaration_statement(Context *ctx, SDL_SHADER_AstVarDeclStatement *vdstmt)
+static SDL_SHADER_AstStatement *new_do_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstStatement *code, SDL_SHADER_AstExpression *condition)
 {
-    DELETE_AST_STATEMENT_NODE(vdstmt);
-    delete_var_declaration(ctx, vdstmt->vardecl);
-    delete_statement(ctx, vdstmt->next);
-    Free(ctx, vdstmt);
-}
-
-static SDL_SHADER_AstStatement *new_do_statement(Context *ctx, SDL_SHADER_AstStatement *code, SDL_SHADER_AstExpression *condition)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstDoStatement, SDL_SHADER_AST_STATEMENT_DO);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstDoStatement, SDL_SHADER_AST_STATEMENT_DO, where);
     retval->code = code;
     retval->condition = condition;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_do_statement(Context *ctx, SDL_SHADER_AstDoStatement *dostmt)
+static SDL_SHADER_AstStatement *new_while_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *code)
 {
-    DELETE_AST_STATEMENT_NODE(dostmt);
-    delete_statement(ctx, dostmt->code);
-    delete_expression(ctx, dostmt->condition);
-    delete_statement(ctx, dostmt->next);
-    Free(ctx, dostmt);
-}
-
-static SDL_SHADER_AstStatement *new_while_statement(Context *ctx, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *code)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstWhileStatement, SDL_SHADER_AST_STATEMENT_WHILE);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstWhileStatement, SDL_SHADER_AST_STATEMENT_WHILE, where);
     retval->code = code;
     retval->condition = condition;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_while_statement(Context *ctx, SDL_SHADER_AstWhileStatement *wstmt)
-{
-    DELETE_AST_STATEMENT_NODE(wstmt);
-    delete_statement(ctx, wstmt->code);
-    delete_expression(ctx, wstmt->condition);
-    delete_statement(ctx, wstmt->next);
-    Free(ctx, wstmt);
-}
-
 static SDL_SHADER_AstForDetails *new_for_details(Context *ctx, SDL_SHADER_AstStatement *initializer, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *step)
 {
-    SDL_SHADER_AstForDetails *retval = (SDL_SHADER_AstForDetails *) Malloc(ctx, sizeof (SDL_SHADER_AstForDetails));
+    SDL_SHADER_AstForDetails *retval = (SDL_SHADER_AstForDetails *) arena_alloc(ctx->ast_arena, sizeof (SDL_SHADER_AstForDetails));
     if (retval) {
         retval->initializer = initializer;
         retval->condition = condition;
@@ -430,116 +291,56 @@ static SDL_SHADER_AstForDetails *new_for_details(Context *ctx, SDL_SHADER_AstSta
     return retval;
 }
 
-static void delete_for_details(Context *ctx, SDL_SHADER_AstForDetails *fordetails)
+static SDL_SHADER_AstStatement *new_for_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstForDetails *details, SDL_SHADER_AstStatement *code)
 {
-    if (fordetails) {
-        delete_statement(ctx, fordetails->initializer);
-        delete_expression(ctx, fordetails->condition);
-        delete_statement(ctx, fordetails->step);
-        Free(ctx, fordetails);
-    }
-}
-
-static SDL_SHADER_AstStatement *new_for_statement(Context *ctx, SDL_SHADER_AstForDetails *details, SDL_SHADER_AstStatement *code)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstForStatement, SDL_SHADER_AST_STATEMENT_FOR);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstForStatement, SDL_SHADER_AST_STATEMENT_FOR, where);
     retval->details = details;
     retval->code = code;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_for_statement(Context *ctx, SDL_SHADER_AstForStatement *forstmt)
-{
-    DELETE_AST_STATEMENT_NODE(forstmt);
-    delete_for_details(ctx, forstmt->details);
-    delete_statement(ctx, forstmt->code);
-    delete_statement(ctx, forstmt->next);
-    Free(ctx, forstmt);
-}
-
-static SDL_SHADER_AstStatement *new_if_statement(Context *ctx, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *code, SDL_SHADER_AstStatement *else_code)
+static SDL_SHADER_AstStatement *new_if_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *code, SDL_SHADER_AstStatement *else_code)
 {
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstIfStatement, SDL_SHADER_AST_STATEMENT_IF);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstIfStatement, SDL_SHADER_AST_STATEMENT_IF, where);
     retval->condition = condition;
     retval->code = code;
     retval->else_code = else_code;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_if_statement(Context *ctx, SDL_SHADER_AstIfStatement *ifstmt)
+static SDL_SHADER_AstSwitchCase *new_switch_case(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *code)
 {
-    DELETE_AST_STATEMENT_NODE(ifstmt);
-    delete_expression(ctx, ifstmt->condition);
-    delete_statement(ctx, ifstmt->code);
-    delete_statement(ctx, ifstmt->else_code);
-    delete_statement(ctx, ifstmt->next);
-    Free(ctx, ifstmt);
-}
-
-static SDL_SHADER_AstSwitchCase *new_switch_case(Context *ctx, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstStatement *code)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstSwitchCase, SDL_SHADER_AST_SWITCH_CASE);
+    NEW_AST_NODE(retval, SDL_SHADER_AstSwitchCase, SDL_SHADER_AST_SWITCH_CASE, where);
     retval->condition = condition;
     retval->code = code;
     retval->next = NULL;
     return retval;
 }
 
-static void delete_switch_case(Context *ctx, SDL_SHADER_AstSwitchCase *swcase)
-{
-    DELETE_AST_NODE(swcase);
-    delete_expression(ctx, swcase->condition);
-    delete_statement(ctx, swcase->code);
-    delete_switch_case(ctx, swcase->next);
-    Free(ctx, swcase);
-}
-
 static SDL_SHADER_AstSwitchCases *new_switch_cases(Context *ctx, SDL_SHADER_AstSwitchCase *first)
 {
     NEW_AST_LIST(retval, SDL_SHADER_AstSwitchCases, first);
     return retval;
 }
 
-static void delete_switch_cases(Context *ctx, SDL_SHADER_AstSwitchCases *cases)
+static SDL_SHADER_AstStatement *new_switch_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstSwitchCases *cases)
 {
-    DELETE_AST_LIST(cases, SDL_SHADER_AstSwitchCase, delete_switch_case);
-}
-
-static SDL_SHADER_AstStatement *new_switch_statement(Context *ctx, SDL_SHADER_AstExpression *condition, SDL_SHADER_AstSwitchCases *cases)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstSwitchStatement, SDL_SHADER_AST_STATEMENT_SWITCH);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstSwitchStatement, SDL_SHADER_AST_STATEMENT_SWITCH, where);
     retval->condition = condition;
     retval->cases = cases;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_switch_statement(Context *ctx, SDL_SHADER_AstSwitchStatement *swstmt)
+static SDL_SHADER_AstStatement *new_return_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *value)
 {
-    DELETE_AST_STATEMENT_NODE(swstmt);
-    delete_expression(ctx, swstmt->condition);
-    delete_switch_cases(ctx, swstmt->cases);
-    delete_statement(ctx, swstmt->next);
-    Free(ctx, swstmt);
-}
-
-static SDL_SHADER_AstStatement *new_return_statement(Context *ctx, SDL_SHADER_AstExpression *value)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstReturnStatement, SDL_SHADER_AST_STATEMENT_RETURN);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstReturnStatement, SDL_SHADER_AST_STATEMENT_RETURN, where);
     retval->value = value;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_return_statement(Context *ctx, SDL_SHADER_AstReturnStatement *rtstmt)
-{
-    DELETE_AST_STATEMENT_NODE(rtstmt);
-    delete_expression(ctx, rtstmt->value);
-    delete_statement(ctx, rtstmt->next);
-    Free(ctx, rtstmt);
-}
-
 static SDL_SHADER_AstAssignment *new_assignment(Context *ctx, SDL_SHADER_AstExpression *expr)
 {
-    SDL_SHADER_AstAssignment *retval = (SDL_SHADER_AstAssignment *) Malloc(ctx, sizeof (SDL_SHADER_AstAssignment));
+    SDL_SHADER_AstAssignment *retval = (SDL_SHADER_AstAssignment *) arena_alloc(ctx->ast_arena, sizeof (SDL_SHADER_AstAssignment));
     if (retval) {
         retval->expr = expr;
         retval->next = NULL;
@@ -547,172 +348,72 @@ static SDL_SHADER_AstAssignment *new_assignment(Context *ctx, SDL_SHADER_AstExpr
     return retval;
 }
 
-static void delete_assignment(Context *ctx, SDL_SHADER_AstAssignment *assignment)
-{
-    if (assignment) {
-        delete_expression(ctx, assignment->expr);
-        delete_assignment(ctx, assignment->next);
-        Free(ctx, assignment);
-    }
-}
-
 static SDL_SHADER_AstAssignments *new_assignments(Context *ctx, SDL_SHADER_AstAssignment *first)
 {
     NEW_AST_LIST(retval, SDL_SHADER_AstAssignments, first);
     return retval;
 }
 
-static void delete_assignments(Context *ctx, SDL_SHADER_AstAssignments *assignments)
+static SDL_SHADER_AstStatement *new_assignment_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstAssignments *assignments, SDL_SHADER_AstExpression *value)
 {
-    DELETE_AST_LIST(assignments, SDL_SHADER_AstAssignment, delete_assignment);
-}
-
-static SDL_SHADER_AstStatement *new_assignment_statement(Context *ctx, SDL_SHADER_AstAssignments *assignments, SDL_SHADER_AstExpression *value)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstAssignStatement, SDL_SHADER_AST_STATEMENT_ASSIGNMENT);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstAssignStatement, SDL_SHADER_AST_STATEMENT_ASSIGNMENT, where);
     retval->assignments = assignments;
     retval->value = value;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_assignment_statement(Context *ctx, SDL_SHADER_AstAssignStatement *asstmt)
+static SDL_SHADER_AstStatement *new_compound_assignment_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *assignment, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *value)
 {
-    DELETE_AST_STATEMENT_NODE(asstmt);
-    delete_assignments(ctx, asstmt->assignments);
-    delete_expression(ctx, asstmt->value);
-    delete_statement(ctx, asstmt->next);
-    Free(ctx, asstmt);
-}
-
-static SDL_SHADER_AstStatement *new_compound_assignment_statement(Context *ctx, SDL_SHADER_AstExpression *assignment, SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *value)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstCompoundAssignStatement, asttype);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstCompoundAssignStatement, asttype, where);
     retval->assignment = assignment;
     retval->value = value;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_compound_assignment_statement(Context *ctx, SDL_SHADER_AstCompoundAssignStatement *asstmt)
+static SDL_SHADER_AstStatement *new_increment_statement(Context *ctx, const AstLocation where, const SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *assignment)
 {
-    DELETE_AST_STATEMENT_NODE(asstmt);
-    delete_expression(ctx, asstmt->assignment);
-    delete_expression(ctx, asstmt->value);
-    delete_statement(ctx, asstmt->next);
-    Free(ctx, asstmt);
-}
-
-static SDL_SHADER_AstStatement *new_increment_statement(Context *ctx, const SDL_SHADER_AstNodeType asttype, SDL_SHADER_AstExpression *assignment)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstIncrementStatement, asttype);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstIncrementStatement, asttype, where);
     retval->assignment = assignment;
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_increment_statement(Context *ctx, SDL_SHADER_AstIncrementStatement *incstmt)
+static SDL_SHADER_AstStatement *new_preincrement_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *assignment)
 {
-    DELETE_AST_STATEMENT_NODE(incstmt);
-    delete_expression(ctx, incstmt->assignment);
-    delete_statement(ctx, incstmt->next);
-    Free(ctx, incstmt);
+    return new_increment_statement(ctx, where, SDL_SHADER_AST_STATEMENT_PREINCREMENT, assignment);
 }
 
-static SDL_SHADER_AstStatement *new_preincrement_statement(Context *ctx, SDL_SHADER_AstExpression *assignment)
+static SDL_SHADER_AstStatement *new_predecrement_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *assignment)
 {
-    return new_increment_statement(ctx, SDL_SHADER_AST_STATEMENT_PREINCREMENT, assignment);
+    return new_increment_statement(ctx, where, SDL_SHADER_AST_STATEMENT_PREDECREMENT, assignment);
 }
 
-static SDL_SHADER_AstStatement *new_predecrement_statement(Context *ctx, SDL_SHADER_AstExpression *assignment)
+static SDL_SHADER_AstStatement *new_postincrement_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *assignment)
 {
-    return new_increment_statement(ctx, SDL_SHADER_AST_STATEMENT_PREDECREMENT, assignment);
+    return new_increment_statement(ctx, where, SDL_SHADER_AST_STATEMENT_POSTINCREMENT, assignment);
 }
 
-static SDL_SHADER_AstStatement *new_postincrement_statement(Context *ctx, SDL_SHADER_AstExpression *assignment)
+static SDL_SHADER_AstStatement *new_postdecrement_statement(Context *ctx, const AstLocation where, SDL_SHADER_AstExpression *assignment)
 {
-    return new_increment_statement(ctx, SDL_SHADER_AST_STATEMENT_POSTINCREMENT, assignment);
+    return new_increment_statement(ctx, where, SDL_SHADER_AST_STATEMENT_POSTDECREMENT, assignment);
 }
 
-static SDL_SHADER_AstStatement *new_postdecrement_statement(Context *ctx, SDL_SHADER_AstExpression *assignment)
+static SDL_SHADER_AstStatement *new_fncall_statement(Context *ctx, const AstLocation where, const char *fnname, SDL_SHADER_AstArguments *arguments)
 {
-    return new_increment_statement(ctx, SDL_SHADER_AST_STATEMENT_POSTDECREMENT, assignment);
-}
-
-static SDL_SHADER_AstStatement *new_fncall_statement(Context *ctx, const char *fnname, SDL_SHADER_AstArguments *arguments)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstFunctionCallStatement, SDL_SHADER_AST_STATEMENT_FUNCTION_CALL);
-    retval->expr = (SDL_SHADER_AstFunctionCallExpression *) new_fncall_expression(ctx, fnname, arguments);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstFunctionCallStatement, SDL_SHADER_AST_STATEMENT_FUNCTION_CALL, where);
+    retval->expr = (SDL_SHADER_AstFunctionCallExpression *) new_fncall_expression(ctx, where, fnname, arguments);
     return (SDL_SHADER_AstStatement *) retval;
 }
 
-static void delete_fncall_statement(Context *ctx, SDL_SHADER_AstFunctionCallStatement *fnstmt)
+static SDL_SHADER_AstStatementBlock *new_statement_block(Context *ctx, const AstLocation where, SDL_SHADER_AstStatement *first)
 {
-    DELETE_AST_STATEMENT_NODE(fnstmt);
-    delete_fncall_expression(ctx, fnstmt->expr);
-    delete_statement(ctx, fnstmt->next);
-    Free(ctx, fnstmt);
-}
-
-static SDL_SHADER_AstStatementBlock *new_statement_block(Context *ctx, SDL_SHADER_AstStatement *first)
-{
-    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstStatementBlock, SDL_SHADER_AST_STATEMENT_BLOCK);
+    NEW_AST_STATEMENT_NODE(retval, SDL_SHADER_AstStatementBlock, SDL_SHADER_AST_STATEMENT_BLOCK, where);
     retval->head = retval->tail = first;
     return retval;
 }
 
-static void delete_statement_block(Context *ctx, SDL_SHADER_AstStatementBlock *stmtblock)
-{
-    DELETE_AST_STATEMENT_NODE(stmtblock);
-    delete_statement(ctx, stmtblock->next);
-    DELETE_AST_LIST(stmtblock, SDL_SHADER_AstStatement, delete_statement);  /* this happens to work, but watch out if that macro changes! */
-}
-
-static void delete_statement(Context *ctx, SDL_SHADER_AstStatement *stmt)
-{
-    SDL_SHADER_AstNode *ast = (SDL_SHADER_AstNode *) stmt;
-    if (!ast) { return; }
-    switch (ast->ast.type) {
-        case SDL_SHADER_AST_STATEMENT_EMPTY: delete_simple_statement(ctx, &ast->simplestmt); return;
-        case SDL_SHADER_AST_STATEMENT_BREAK: delete_break_statement(ctx, &ast->breakstmt); return;
-        case SDL_SHADER_AST_STATEMENT_CONTINUE: delete_continue_statement(ctx, &ast->contstmt); return;
-        case SDL_SHADER_AST_STATEMENT_DISCARD: delete_simple_statement(ctx, &ast->simplestmt); return;
-        case SDL_SHADER_AST_STATEMENT_VARDECL: delete_var_declaration_statement(ctx, &ast->vardeclstmt); return;
-        case SDL_SHADER_AST_STATEMENT_DO: delete_do_statement(ctx, &ast->dostmt); return;
-        case SDL_SHADER_AST_STATEMENT_WHILE: delete_while_statement(ctx, &ast->whilestmt); return;
-        case SDL_SHADER_AST_STATEMENT_FOR: delete_for_statement(ctx, &ast->forstmt); return;
-        case SDL_SHADER_AST_STATEMENT_IF: delete_if_statement(ctx, &ast->ifstmt); return;
-        case SDL_SHADER_AST_STATEMENT_SWITCH: delete_switch_statement(ctx, &ast->switchstmt); return;
-        case SDL_SHADER_AST_STATEMENT_RETURN: delete_return_statement(ctx, &ast->returnstmt); return;
-        case SDL_SHADER_AST_STATEMENT_ASSIGNMENT: delete_assignment_statement(ctx, &ast->assignstmt); return;
-        case SDL_SHADER_AST_STATEMENT_FUNCTION_CALL: delete_fncall_statement(ctx, &ast->fncallstmt); return;
-        case SDL_SHADER_AST_STATEMENT_BLOCK: delete_statement_block(ctx, &ast->stmtblock); return;
-
-        case SDL_SHADER_AST_STATEMENT_PREINCREMENT:
-        case SDL_SHADER_AST_STATEMENT_PREDECREMENT:
-        case SDL_SHADER_AST_STATEMENT_POSTINCREMENT:
-        case SDL_SHADER_AST_STATEMENT_POSTDECREMENT:
-            delete_increment_statement(ctx, &ast->incrementstmt);
-            return;
-
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNMUL:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNDIV:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNMOD:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNADD:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNSUB:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNLSHIFT:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNRSHIFT:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNAND:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNXOR:
-        case SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNOR:
-            delete_compound_assignment_statement(ctx, &ast->compoundassignstmt);
-            return;
-
-        default: break;
-    }
-    SDL_assert(!"Unexpected statement type");
-}
-
-static SDL_SHADER_AstStructMember *new_struct_member(Context *ctx, const char *datatype_name, const char *name, SDL_SHADER_AstExpression *arraysize, SDL_SHADER_AstAtAttribute *atattr)
+static SDL_SHADER_AstStructMember *new_struct_member(Context *ctx, const AstLocation where, const char *datatype_name, const char *name, SDL_SHADER_AstExpression *arraysize, SDL_SHADER_AstAtAttribute *atattr)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstStructMember,SDL_SHADER_AST_STRUCT_MEMBER);
+    NEW_AST_NODE(retval, SDL_SHADER_AstStructMember,SDL_SHADER_AST_STRUCT_MEMBER, where);
     retval->datatype_name = datatype_name;  /* strcache'd */
     retval->name = name;  /* strcache'd */
     retval->arraysize = arraysize;
@@ -721,62 +422,32 @@ static SDL_SHADER_AstStructMember *new_struct_member(Context *ctx, const char *d
     return retval;
 }
 
-static void delete_struct_member(Context *ctx, SDL_SHADER_AstStructMember *member)
-{
-    DELETE_AST_NODE(member);
-    delete_expression(ctx, member->arraysize);
-    delete_at_attribute(ctx, member->attribute);
-    delete_struct_member(ctx, member->next);
-    Free(ctx, member);
-}
-
 static SDL_SHADER_AstStructMembers *new_struct_members(Context *ctx, SDL_SHADER_AstStructMember *first)
 {
     NEW_AST_LIST(retval, SDL_SHADER_AstStructMembers, first);
     return retval;
 }
 
-static void delete_struct_members(Context *ctx, SDL_SHADER_AstStructMembers *members)
+static SDL_SHADER_AstStructDeclaration *new_struct_declaration(Context *ctx, const AstLocation where, const char *name, SDL_SHADER_AstStructMembers *members)
 {
-    DELETE_AST_LIST(members, SDL_SHADER_AstStructMember, delete_struct_member);
-}
-
-static SDL_SHADER_AstStructDeclaration *new_struct_declaration(Context *ctx, const char *name, SDL_SHADER_AstStructMembers *members)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstStructDeclaration, SDL_SHADER_AST_STRUCT_DECLARATION);
+    NEW_AST_NODE(retval, SDL_SHADER_AstStructDeclaration, SDL_SHADER_AST_STRUCT_DECLARATION, where);
     retval->name = name;  /* strcache'd */
     retval->members = members;
     retval->nextstruct = NULL;
     return retval;
 }
 
-static void delete_struct_declaration(Context *ctx, SDL_SHADER_AstStructDeclaration *decl)
+static SDL_SHADER_AstTranslationUnit *new_struct_declaration_unit(Context *ctx, const AstLocation where, SDL_SHADER_AstStructDeclaration *decl)
 {
-    DELETE_AST_NODE(decl);
-    delete_struct_members(ctx, decl->members);
-    /* don't delete decl->nextstruct, it's a separate linked list and you'll delete things twice. */
-    Free(ctx, decl);
-}
-
-static SDL_SHADER_AstTranslationUnit *new_struct_declaration_unit(Context *ctx, SDL_SHADER_AstStructDeclaration *decl)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstStructDeclarationUnit, SDL_SHADER_AST_TRANSUNIT_STRUCT);
+    NEW_AST_NODE(retval, SDL_SHADER_AstStructDeclarationUnit, SDL_SHADER_AST_TRANSUNIT_STRUCT, where);
     retval->next = NULL;
     retval->decl = decl;
     return (SDL_SHADER_AstTranslationUnit *) retval;
 }
 
-static void delete_struct_declaration_unit(Context *ctx, SDL_SHADER_AstStructDeclarationUnit *strunit)
+static SDL_SHADER_AstFunctionParam *new_function_param(Context *ctx, const AstLocation where, const char *datatype_name, const char *name, SDL_SHADER_AstAtAttribute *atattr)
 {
-    DELETE_AST_NODE(strunit);
-    delete_struct_declaration(ctx, strunit->decl);
-    delete_translation_unit(ctx, strunit->next);
-    Free(ctx, strunit);
-}
-
-static SDL_SHADER_AstFunctionParam *new_function_param(Context *ctx, const char *datatype_name, const char *name, SDL_SHADER_AstAtAttribute *atattr)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstFunctionParam, SDL_SHADER_AST_FUNCTION_PARAM);
+    NEW_AST_NODE(retval, SDL_SHADER_AstFunctionParam, SDL_SHADER_AST_FUNCTION_PARAM, where);
     retval->datatype_name = datatype_name;  /* strcache'd */
     retval->name = name;  /* strcache'd */
     retval->attribute = atattr;
@@ -784,28 +455,15 @@ static SDL_SHADER_AstFunctionParam *new_function_param(Context *ctx, const char
     return retval;
 }
 
-static void delete_function_param(Context *ctx, SDL_SHADER_AstFunctionParam *param)
-{
-    DELETE_AST_NODE(param);
-    delete_at_attribute(ctx, param->attribute);
-    delete_function_param(ctx, param->next);
-    Free(ctx, param);
-}
-
 static SDL_SHADER_AstFunctionParams *new_function_params(Context *ctx, SDL_SHADER_AstFunctionParam *first)
 {
     NEW_AST_LIST(retval, SDL_SHADER_AstFunctionParams, first);
     return retval;
 }
 
-static void delete_function_params(Context *ctx, SDL_SHADER_AstFunctionParams *params)
+static SDL_SHADER_AstFunction *new_function(Context *ctx, const AstLocation where, const char *rettype, const char *name, SDL_SHADER_AstFunctionParams *params, SDL_SHADER_AstAtAttribute *atattr, SDL_SHADER_AstStatementBlock *code)
 {
-    DELETE_AST_LIST(params, SDL_SHADER_AstFunctionParam, delete_function_param);
-}
-
-static SDL_SHADER_AstFunction *new_function(Context *ctx, const char *rettype, const char *name, SDL_SHADER_AstFunctionParams *params, SDL_SHADER_AstAtAttribute *atattr, SDL_SHADER_AstStatementBlock *code)
-{
-    NEW_AST_NODE(retval, SDL_SHADER_AstFunction, SDL_SHADER_AST_FUNCTION);
+    NEW_AST_NODE(retval, SDL_SHADER_AstFunction, SDL_SHADER_AST_FUNCTION, where);
     retval->fntype = SDL_SHADER_AST_FNTYPE_UNKNOWN;  /* until semantic analysis */
     retval->datatype_name = rettype; /* strcache'd (or NULL for "void") */
     retval->name = name; /* strcache'd */
@@ -816,195 +474,612 @@ static SDL_SHADER_AstFunction *new_function(Context *ctx, const char *rettype, c
     return retval;
 }
 
-static void delete_function(Context *ctx, SDL_SHADER_AstFunction *fn)
-{
-    DELETE_AST_NODE(fn);
-    delete_function_params(ctx, fn->params);
-    delete_at_attribute(ctx, fn->attribute);
-    delete_statement_block(ctx, fn->code);
-    /* don't delete fn->nextfn, it's a separate linked list and you'll delete things twice. */
-    Free(ctx, fn);
-}
-
-static SDL_SHADER_AstTranslationUnit *new_function_unit(Context *ctx, SDL_SHADER_AstFunction *fn)
+static SDL_SHADER_AstTranslationUnit *new_function_unit(Context *ctx, const AstLocation where, SDL_SHADER_AstFunction *fn)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstFunctionUnit, SDL_SHADER_AST_TRANSUNIT_FUNCTION);
+    NEW_AST_NODE(retval, SDL_SHADER_AstFunctionUnit, SDL_SHADER_AST_TRANSUNIT_FUNCTION, where);
     retval->next = NULL;
     retval->fn = fn;
     return (SDL_SHADER_AstTranslationUnit *) retval;
 }
 
-static void delete_function_unit(Context *ctx, SDL_SHADER_AstFunctionUnit *fnunit)
+static SDL_SHADER_AstTranslationUnits *new_translation_units(Context *ctx, SDL_SHADER_AstTranslationUnit *first)
+{
+    NEW_AST_LIST(retval, SDL_SHADER_AstTranslationUnits, first);
+    return retval;
+}
+
+static SDL_SHADER_AstShader *new_shader(Context *ctx, const AstLocation where, SDL_SHADER_AstTranslationUnits *units)
+{
+    NEW_AST_NODE(retval, SDL_SHADER_AstShader, SDL_SHADER_AST_SHADER, where);
+    retval->units = units;
+    return retval;
+}
+
+
+// This is where the actual parsing happens. It's Lemon-generated!
+#define __SDL_SHADER_SDLSL_COMPILER__ 1
+#include "SDL_shader_parser.h"
+
+/* Numeric literals are parsed straight out of the token, without copying
+   them to a null-terminated buffer for the C runtime, which is slow,
+   locale-dependent, and doesn't understand our suffixes anyhow. */
+
+static SDL_bool is_literal_suffix(const char ch, const char *suffixes)
 {
-    DELETE_AST_NODE(fnunit);
-    delete_function(ctx, fnunit->fn);
-    delete_translation_unit(ctx, fnunit->next);
-    Free(ctx, fnunit);
+    return ((ch != '\0') && (SDL_strchr(suffixes, ch) != NULL)) ? SDL_TRUE : SDL_FALSE;
 }
 
-static void delete_translation_unit(Context *ctx, SDL_SHADER_AstTranslationUnit *unit)
+static Uint32 literal_digit(const char ch)
 {
-    SDL_SHADER_AstNode *ast = (SDL_SHADER_AstNode *) unit;
-    if (!ast) { return; }
-    switch (ast->ast.type) {
-        case SDL_SHADER_AST_TRANSUNIT_FUNCTION: delete_function_unit(ctx, &ast->fnunit); return;
-        case SDL_SHADER_AST_TRANSUNIT_STRUCT: delete_struct_declaration_unit(ctx, &ast->structdeclunit); return;
-        default: break;
+    if ((ch >= '0') && (ch <= '9')) {
+        return (Uint32) (ch - '0');
+    } else if ((ch >= 'a') && (ch <= 'f')) {
+        return (Uint32) (ch - 'a') + 10;
+    } else if ((ch >= 'A') && (ch <= 'F')) {
+        return (Uint32) (ch - 'A') + 10;
     }
-    SDL_assert(!"Unexpected translation unit type");
+    return 0xFF;  /* not a digit in any base we care about. */
+}
+
+/* 'x' character constants, with C escapes. Multiple chars pack together like GCC does. */
+static Sint64 charliteral_to_i64(const char *str, const char *end)
+{
+    Uint64 retval = 0;
+    while (str < end) {
+        Uint64 ch = (Uint8) *(str++);
+        if ((ch == '\\') && (str < end)) {
+            ch = (Uint8) *(str++);
+            switch (ch) {
+                case 'a': ch = '\a'; break;
+                case 'b': ch = '\b'; break;
+                case 'f': ch = '\f'; break;
+                case 'n': ch = '\n'; break;
+                case 'r': ch = '\r'; break;
+                case 't': ch = '\t'; break;
+                case 'v': ch = '\v'; break;
+                case 'x':
+                    for (ch = 0; (str < end) && (literal_digit(*str) < 16); str++) {
+                        ch = (ch << 4) | literal_digit(*str);
+                    }
+                    break;
+                default:
+                    if ((ch >= '0') && (ch <= '7')) {
+                        for (ch -= '0'; (str < end) && (literal_digit(*str) < 8); str++) {
+                            ch = (ch << 3) | literal_digit(*str);
+                        }
+                    }
+                    break;  /* everything else (\' \" \? \\) is just itself. */
+            }
+        }
+        retval = (retval << 8) | (ch & 0xFF);
+    }
+    return (Sint64) retval;
 }
 
-static SDL_SHADER_AstTranslationUnits *new_translation_units(Context *ctx, SDL_SHADER_AstTranslationUnit *first)
+/* decimal, 0x hex, or 0-prefixed octal, with optional [uUlL] suffixes.
+   Values too big for an Sint64 clamp to its max, like strtoll() does.
+   Returns SDL_FALSE if an octal constant has an 8 or 9 in it; the lexer
+   takes those, since it doesn't know about octal. */
+static SDL_bool strtoi64(const char *str, const size_t slen, Sint64 *_retval)
 {
-    NEW_AST_LIST(retval, SDL_SHADER_AstTranslationUnits, first);
-    return retval;
+    const char *end = str + slen;
+    Uint64 retval = 0;
+    Uint32 base = 10;
+    SDL_bool clamped = SDL_FALSE;
+
+    if ((slen >= 2) && (*str == '\'')) {
+        *_retval = charliteral_to_i64(str + 1, end - 1);
+        return SDL_TRUE;
+    }
+
+    while ((end > str) && is_literal_suffix(end[-1], "uUlL")) {
+        end--;
+    }
+
+    if (((end - str) > 2) && (str[0] == '0') && ((str[1] == 'x') || (str[1] == 'X'))) {
+        base = 16;
+        str += 2;
+    } else if (((end - str) > 1) && (str[0] == '0')) {
+        base = 8;
+        str++;
+    }
+
+    for (; str < end; str++) {
+        const Uint32 digit = literal_digit(*str);
+        if (digit >= base) {
+            SDL_assert(base == 8);  /* the lexer shouldn't let anything else through. */
+            *_retval = 0;
+            return SDL_FALSE;
+        } else if (clamped || (retval > ((((Uint64) SDL_MAX_SINT64) - digit) / base))) {
+            clamped = SDL_TRUE;  /* keep going, in case there's a bad octal digit after this. */
+        } else {
+            retval = (retval * base) + digit;
+        }
+    }
+
+    *_retval = clamped ? SDL_MAX_SINT64 : (Sint64) retval;
+    return SDL_TRUE;
 }
 
-static void delete_translation_units(Context *ctx, SDL_SHADER_AstTranslationUnits *units)
+/* The slow way to convert a float, for what Clinger's fast path can't do.
+   This is the "simple decimal conversion" that Go's strconv falls back to:
+   keep the digits in decimal, shift them by powers of two until the binary
+   exponent falls out, then round once. It's slow, but it's correctly rounded,
+   and unlike SDL_strtod() it doesn't care what the C runtime's current
+   locale thinks a decimal point looks like. */
+#define SLOWFLOAT_MAX_DIGITS 800  /* a double's exact halfway points need at most 767. */
+#define SLOWFLOAT_MAX_SHIFT 60  /* the most bits we can shift at once without overflowing a Uint64. */
+
+typedef struct SlowFloat
 {
-    DELETE_AST_LIST(units, SDL_SHADER_AstTranslationUnit, delete_translation_unit);
+    Uint8 digits[SLOWFLOAT_MAX_DIGITS];  /* 0 to 9, not ASCII, most significant first. */
+    Sint32 count;
+    Sint32 point;  /* the value is 0.digits * 10^point. */
+    SDL_bool truncated;  /* SDL_TRUE if nonzero digits fell off the end of (digits). */
+} SlowFloat;
+
+static void slowfloat_trim(SlowFloat *d)
+{
+    while ((d->count > 0) && (d->digits[d->count - 1] == 0)) {
+        d->count--;
+    }
+    if (d->count == 0) {
+        d->point = 0;
+    }
 }
 
-static SDL_SHADER_AstShader *new_shader(Context *ctx, SDL_SHADER_AstTranslationUnits *units)
+/* multiply by 2^k, working up from the least significant digit. */
+static void slowfloat_left_shift(SlowFloat *d, const Uint32 k)
 {
-    NEW_AST_NODE(retval, SDL_SHADER_AstShader, SDL_SHADER_AST_SHADER);
-    retval->units = units;
-    return retval;
+    Uint8 scratch[SLOWFLOAT_MAX_DIGITS + 19];  /* 2^60 has 19 digits, so that's the most this can add. */
+    Sint32 r = d->count;
+    Sint32 w = (Sint32) sizeof (scratch);
+    Uint64 n = 0;
+    Sint32 total;
+    Sint32 i;
+
+    while ((r > 0) || (n > 0)) {
+        if (r > 0) {
+            n += ((Uint64) d->digits[--r]) << k;
+        }
+        scratch[--w] = (Uint8) (n % 10);
+        n /= 10;
+    }
+
+    total = ((Sint32) sizeof (scratch)) - w;
+    d->point += total - d->count;
+    for (i = SLOWFLOAT_MAX_DIGITS; i < total; i++) {
+        if (scratch[w + i] != 0) {
+            d->truncated = SDL_TRUE;
+        }
+    }
+    d->count = (total < SLOWFLOAT_MAX_DIGITS) ? total : SLOWFLOAT_MAX_DIGITS;
+    SDL_memcpy(d->digits, &scratch[w], d->count);
+    slowfloat_trim(d);
+}
+
+/* divide by 2^k, working down from the most significant digit. */
+static void slowfloat_right_shift(SlowFloat *d, const Uint32 k)
+{
+    const Uint64 mask = (((Uint64) 1) << k) - 1;
+    Sint32 r = 0;
+    Sint32 w = 0;
+    Uint64 n = 0;
+
+    /* pull in digits until there's something to shift out. */
+    for (; (n >> k) == 0; r++) {
+        if (r >= d->count) {
+            if (n == 0) {
+                d->count = 0;
+                return;
+            }
+            while ((n >> k) == 0) {
+                n *= 10;
+                r++;
+            }
+            break;
+        }
+        n = (n * 10) + d->digits[r];
+    }
+    d->point -= r - 1;
+
+    for (; r < d->count; r++) {
+        const Uint8 digit = d->digits[r];
+        d->digits[w++] = (Uint8) (n >> k);
+        n = ((n & mask) * 10) + digit;
+    }
+
+    while (n > 0) {
+        const Uint8 digit = (Uint8) (n >> k);
+        if (w < SLOWFLOAT_MAX_DIGITS) {
+            d->digits[w++] = digit;
+        } else if (digit > 0) {
+            d->truncated = SDL_TRUE;
+        }
+        n = (n & mask) * 10;
+    }
+
+    d->count = w;
+    slowfloat_trim(d);
 }
 
-static void delete_shader(Context *ctx, SDL_SHADER_AstShader *shader)
+/* multiply by 2^k, or divide by 2^-k. */
+static void slowfloat_shift(SlowFloat *d, Sint32 k)
 {
-    DELETE_AST_NODE(shader);
-    delete_translation_units(ctx, shader->units);
-    Free(ctx, shader);
+    if (d->count == 0) {
+        return;
+    }
+    while (k > 0) {
+        const Sint32 bits = (k < SLOWFLOAT_MAX_SHIFT) ? k : SLOWFLOAT_MAX_SHIFT;
+        slowfloat_left_shift(d, (Uint32) bits);
+        k -= bits;
+    }
+    while (k < 0) {
+        const Sint32 bits = (-k < SLOWFLOAT_MAX_SHIFT) ? -k : SLOWFLOAT_MAX_SHIFT;
+        slowfloat_right_shift(d, (Uint32) bits);
+        k += bits;
+    }
 }
 
+/* SDL_TRUE if rounding to (nd) digits should round up. Exact halves round to even. */
+static SDL_bool slowfloat_should_round_up(const SlowFloat *d, const Sint32 nd)
+{
+    if ((nd < 0) || (nd >= d->count)) {
+        return SDL_FALSE;
+    } else if ((d->digits[nd] == 5) && ((nd + 1) == d->count)) {
+        /* if digits fell off the end, it's really a little more than half. */
+        return (d->truncated || ((nd > 0) && (d->digits[nd - 1] & 1))) ? SDL_TRUE : SDL_FALSE;
+    }
+    return (d->digits[nd] >= 5) ? SDL_TRUE : SDL_FALSE;
+}
 
-// This is where the actual parsing happens. It's Lemon-generated!
-#define __SDL_SHADER_SDLSL_COMPILER__ 1
-#include "SDL_shader_parser.h"
+/* the integer part, rounded by what's after the decimal point. */
+static Uint64 slowfloat_rounded_integer(const SlowFloat *d)
+{
+    Uint64 retval = 0;
+    Sint32 i;
 
-static Sint64 strtoi64(const char *str, const size_t slen)
-{
-    Sint64 retval = 0;
-    char buf[64];
-    if (slen < sizeof (buf)) {
-        char *endp = NULL;
-        SDL_memcpy(buf, str, slen);
-        buf[slen] = '\0';
-        retval = SDL_strtoll(buf, &endp, 0);
-        if (*endp != '\0') {
-            SDL_assert(!"Tokenizer let a bogus int64 through...?");
-            retval = 0;  /* invalid string (empty string returns zero anyhow, so that works here too). */
+    if (d->point > 20) {
+        return ~((Uint64) 0);  /* too big. */
+    }
+
+    for (i = 0; (i < d->point) && (i < d->count); i++) {
+        retval = (retval * 10) + d->digits[i];
+    }
+    for (; i < d->point; i++) {
+        retval *= 10;
+    }
+    if (slowfloat_should_round_up(d, d->point)) {
+        retval++;
+    }
+    return retval;
+}
+
+/* (str) to (end) is a float literal, minus its suffix, that the lexer already checked. */
+static double strtodouble_slow(const char *str, const char *end)
+{
+    static const Sint32 powers_of_two[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };  /* the most bits that fit in 10^i. */
+    const Sint32 max_power = (Sint32) SDL_arraysize(powers_of_two);
+    SlowFloat d;
+    SDL_bool sawdot = SDL_FALSE;
+    Sint32 exponent = 0;
+    Uint64 mantissa;
+    Uint64 bits;
+    double retval;
+
+    d.count = 0;
+    d.point = 0;
+    d.truncated = SDL_FALSE;
+
+    for (; str < end; str++) {
+        if (*str == '.') {
+            sawdot = SDL_TRUE;
+            d.point = d.count;
+        } else if ((*str < '0') || (*str > '9')) {
+            break;
+        } else if ((*str == '0') && (d.count == 0)) {
+            d.point--;  /* leading zeros only move the decimal point. */
+        } else if (d.count < SLOWFLOAT_MAX_DIGITS) {
+            d.digits[d.count++] = (Uint8) (*str - '0');
+        } else if (*str != '0') {
+            d.truncated = SDL_TRUE;
         }
     }
+
+    if (!sawdot) {
+        d.point = d.count;
+    }
+
+    if ((str < end) && ((*str == 'e') || (*str == 'E'))) {
+        SDL_bool negative = SDL_FALSE;
+        Sint32 e = 0;
+        str++;
+        if ((str < end) && ((*str == '+') || (*str == '-'))) {
+            negative = (*(str++) == '-') ? SDL_TRUE : SDL_FALSE;
+        }
+        for (; (str < end) && (*str >= '0') && (*str <= '9'); str++) {
+            if (e < 100000) {  /* way past where anything overflows or underflows, so stop counting. */
+                e = (e * 10) + (*str - '0');
+            }
+        }
+        d.point += negative ? -e : e;
+    }
+
+    SDL_assert(str == end);
+
+    if (d.count == 0) {
+        return 0.0;
+    } else if (d.point > 310) {
+        goto strtodouble_slow_overflow;
+    } else if (d.point < -330) {
+        return 0.0;
+    }
+
+    /* scale into [0.5, 1), keeping track of the power of two that took. */
+    while (d.point > 0) {
+        const Sint32 n = (d.point >= max_power) ? 27 : powers_of_two[d.point];
+        slowfloat_shift(&d, -n);
+        exponent += n;
+    }
+    while ((d.point < 0) || ((d.point == 0) && (d.digits[0] < 5))) {
+        const Sint32 n = (-d.point >= max_power) ? 27 : powers_of_two[-d.point];
+        slowfloat_shift(&d, n);
+        exponent -= n;
+    }
+
+    exponent--;  /* a double's mantissa is in [1, 2), not [0.5, 1). */
+
+    /* too small for a normal double? Shift down to a denormal. */
+    if (exponent < -1022) {
+        const Sint32 n = -1022 - exponent;
+        slowfloat_shift(&d, -n);
+        exponent += n;
+    }
+
+    if ((exponent + 1023) >= 0x7FF) {
+        goto strtodouble_slow_overflow;
+    }
+
+    /* pull out 53 bits, rounded. */
+    slowfloat_shift(&d, 53);
+    mantissa = slowfloat_rounded_integer(&d);
+
+    /* rounding up might have carried into another bit. */
+    if (mantissa == (((Uint64) 2) << 52)) {
+        mantissa >>= 1;
+        exponent++;
+        if ((exponent + 1023) >= 0x7FF) {
+            goto strtodouble_slow_overflow;
+        }
+    }
+
+    if ((mantissa & (((Uint64) 1) << 52)) == 0) {
+        exponent = -1023;  /* denormal. */
+    }
+
+    bits = (mantissa & ((((Uint64) 1) << 52) - 1)) | (((Uint64) ((exponent + 1023) & 0x7FF)) << 52);
+    SDL_memcpy(&retval, &bits, sizeof (retval));
+    return retval;
+
+strtodouble_slow_overflow:
+    bits = ((Uint64) 0x7FF) << 52;  /* infinity, like strtod() gives you. */
+    SDL_memcpy(&retval, &bits, sizeof (retval));
     return retval;
 }
 
+/* This takes the fast path from Clinger's algorithm: if the significant
+   digits fit in a double's 53-bit mantissa and the power of ten is exact
+   (10^22 is the biggest one that is), one multiply or divide rounds
+   correctly. That covers nearly every float in a real shader; anything
+   else goes to strtodouble_slow(). */
 static double strtodouble(const char *str, const size_t slen)
 {
-    double retval = 0.0;
-    char buf[64];
-    if (slen < sizeof (buf)) {
-        char *endp = NULL;
-        SDL_memcpy(buf, str, slen);
-        buf[slen] = '\0';
-        retval = SDL_strtod(buf, &endp);
-        if (*endp != '\0') {
-            SDL_assert(!"Tokenizer let a bogus double through...?");
-            retval = 0.0;  /* invalid string (empty string returns zero anyhow, so that works here too). */
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const Sint32 max_exponent = (Sint32) (SDL_arraysize(powers_of_ten) - 1);
+    const char *end = str + slen;
+    const char *ptr = str;
+    Uint64 mantissa = 0;
+    Sint32 digits = 0;
+    Sint32 exponent = 0;
+    SDL_bool truncated = SDL_FALSE;
+
+    while ((end > str) && is_literal_suffix(end[-1], "fFhH")) {
+        end--;
+    }
+
+    for (; (ptr < end) && (*ptr >= '0') && (*ptr <= '9'); ptr++) {
+        if ((mantissa == 0) && (*ptr == '0')) {
+            continue;  /* leading zeros don't count. */
+        } else if (digits < 19) {  /* 19 digits always fit in a Uint64. */
+            mantissa = (mantissa * 10) + (Uint64) (*ptr - '0');
+            digits++;
+        } else {
+            truncated = SDL_TRUE;
+            exponent++;
         }
     }
-    return retval;
+
+    if ((ptr < end) && (*ptr == '.')) {
+        for (ptr++; (ptr < end) && (*ptr >= '0') && (*ptr <= '9'); ptr++) {
+            if ((mantissa == 0) && (*ptr == '0')) {
+                exponent--;
+            } else if (digits < 19) {
+                mantissa = (mantissa * 10) + (Uint64) (*ptr - '0');
+                digits++;
+                exponent--;
+            } else {
+                truncated = SDL_TRUE;
+            }
+        }
+    }
+
+    if ((ptr < end) && ((*ptr == 'e') || (*ptr == 'E'))) {
+        SDL_bool negative = SDL_FALSE;
+        Sint32 e = 0;
+        ptr++;
+        if ((ptr < end) && ((*ptr == '+') || (*ptr == '-'))) {
+            negative = (*(ptr++) == '-') ? SDL_TRUE : SDL_FALSE;
+        }
+        for (; (ptr < end) && (*ptr >= '0') && (*ptr <= '9'); ptr++) {
+            if (e < 100000) {  /* way past where anything overflows or underflows, so stop counting. */
+                e = (e * 10) + (*ptr - '0');
+            }
+        }
+        exponent += negative ? -e : e;
+    }
+
+    if (ptr != end) {
+        SDL_assert(!"Tokenizer let a bogus double through...?");
+        return 0.0;
+    } else if (mantissa == 0) {
+        return 0.0;
+    } else if (!truncated && (mantissa <= (((Uint64) 1) << 53)) && (exponent >= -max_exponent) && (exponent <= max_exponent)) {
+        const double dbl = (double) mantissa;  /* exact, since it fits in 53 bits. */
+        return (exponent < 0) ? (dbl / powers_of_ten[-exponent]) : (dbl * powers_of_ten[exponent]);
+    }
+
+    return strtodouble_slow(str, end);
+}
+
+/* Lexer tokens that map straight to a parser token. Zero means it needs
+   more work (literals, identifiers), or isn't valid here at all. */
+static const Uint8 lemon_token_map[TOKEN_PP_UNARY_PLUS + 1] = {
+    [','] = TOKEN_SDLSL_COMMA,
+    ['='] = TOKEN_SDLSL_ASSIGN,
+    [TOKEN_ADDASSIGN] = TOKEN_SDLSL_PLUSASSIGN,
+    [TOKEN_SUBASSIGN] = TOKEN_SDLSL_MINUSASSIGN,
+    [TOKEN_MULTASSIGN] = TOKEN_SDLSL_STARASSIGN,
+    [TOKEN_DIVASSIGN] = TOKEN_SDLSL_SLASHASSIGN,
+    [TOKEN_MODASSIGN] = TOKEN_SDLSL_PERCENTASSIGN,
+    [TOKEN_LSHIFTASSIGN] = TOKEN_SDLSL_LSHIFTASSIGN,
+    [TOKEN_RSHIFTASSIGN] = TOKEN_SDLSL_RSHIFTASSIGN,
+    [TOKEN_ANDASSIGN] = TOKEN_SDLSL_ANDASSIGN,
+    [TOKEN_ORASSIGN] = TOKEN_SDLSL_ORASSIGN,
+    [TOKEN_XORASSIGN] = TOKEN_SDLSL_XORASSIGN,
+    ['?'] = TOKEN_SDLSL_QUESTION,
+    [TOKEN_OROR] = TOKEN_SDLSL_OROR,
+    [TOKEN_ANDAND] = TOKEN_SDLSL_ANDAND,
+    ['|'] = TOKEN_SDLSL_OR,
+    ['^'] = TOKEN_SDLSL_XOR,
+    ['&'] = TOKEN_SDLSL_AND,
+    [TOKEN_EQL] = TOKEN_SDLSL_EQL,
+    [TOKEN_NEQ] = TOKEN_SDLSL_NEQ,
+    ['<'] = TOKEN_SDLSL_LT,
+    [TOKEN_LEQ] = TOKEN_SDLSL_LEQ,
+    ['>'] = TOKEN_SDLSL_GT,
+    [TOKEN_GEQ] = TOKEN_SDLSL_GEQ,
+    [TOKEN_LSHIFT] = TOKEN_SDLSL_LSHIFT,
+    [TOKEN_RSHIFT] = TOKEN_SDLSL_RSHIFT,
+    ['+'] = TOKEN_SDLSL_PLUS,
+    ['-'] = TOKEN_SDLSL_MINUS,
+    ['*'] = TOKEN_SDLSL_STAR,
+    ['/'] = TOKEN_SDLSL_SLASH,
+    ['%'] = TOKEN_SDLSL_PERCENT,
+    ['!'] = TOKEN_SDLSL_EXCLAMATION,
+    ['~'] = TOKEN_SDLSL_COMPLEMENT,
+    [TOKEN_DECREMENT] = TOKEN_SDLSL_MINUSMINUS,
+    [TOKEN_INCREMENT] = TOKEN_SDLSL_PLUSPLUS,
+    ['.'] = TOKEN_SDLSL_DOT,
+    ['['] = TOKEN_SDLSL_LBRACKET,
+    [']'] = TOKEN_SDLSL_RBRACKET,
+    ['('] = TOKEN_SDLSL_LPAREN,
+    [')'] = TOKEN_SDLSL_RPAREN,
+    [':'] = TOKEN_SDLSL_COLON,
+    [';'] = TOKEN_SDLSL_SEMICOLON,
+    ['{'] = TOKEN_SDLSL_LBRACE,
+    ['}'] = TOKEN_SDLSL_RBRACE,
+    ['@'] = TOKEN_SDLSL_AT
+};
+
+/* Keywords, in a perfect hash on the first two chars and the length (see
+   keyword_hash()), so spotting one costs a single compare instead of a
+   strcmp against every keyword. If you add a keyword, make sure it doesn't
+   collide with the others, and tweak the hash if it does. */
+typedef struct Keyword
+{
+    const char *str;
+    size_t len;
+    int lemon_token;
+} Keyword;
+
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 8
+#define KEYWORD_HASH_SIZE 64
+
+static const Keyword keywords[KEYWORD_HASH_SIZE] = {
+    [3] = { "break", 5, TOKEN_SDLSL_BREAK },
+    [4] = { "function", 8, TOKEN_SDLSL_FUNCTION },
+    [20] = { "true", 4, TOKEN_SDLSL_TRUE },
+    [27] = { "switch", 6, TOKEN_SDLSL_SWITCH },
+    [29] = { "struct", 6, TOKEN_SDLSL_STRUCT },
+    [33] = { "false", 5, TOKEN_SDLSL_FALSE },
+    [34] = { "while", 5, TOKEN_SDLSL_WHILE },
+    [37] = { "case", 4, TOKEN_SDLSL_CASE },
+    [39] = { "if", 2, TOKEN_SDLSL_IF },
+    [41] = { "default", 7, TOKEN_SDLSL_DEFAULT },
+    [44] = { "void", 4, TOKEN_SDLSL_VOID },
+    [49] = { "discard", 7, TOKEN_SDLSL_DISCARD },
+    [53] = { "continue", 8, TOKEN_SDLSL_CONTINUE },
+    [55] = { "var", 3, TOKEN_SDLSL_VAR },
+    [56] = { "do", 2, TOKEN_SDLSL_DO },
+    [57] = { "else", 4, TOKEN_SDLSL_ELSE },
+    [59] = { "for", 3, TOKEN_SDLSL_FOR },
+    [62] = { "return", 6, TOKEN_SDLSL_RETURN }
+};
+
+static inline Uint32 keyword_hash(const char *str, const size_t len)
+{
+    return (((Uint32) (Uint8) str[0]) ^ (((Uint32) (Uint8) str[1]) << 1) ^ ((Uint32) len)) & (KEYWORD_HASH_SIZE - 1);
+}
+
+/* returns the keyword's parser token, or zero if this isn't a keyword. */
+static int find_keyword(const char *str, const size_t len)
+{
+    if ((len >= KEYWORD_MIN_LEN) && (len <= KEYWORD_MAX_LEN)) {
+        const Keyword *kw = &keywords[keyword_hash(str, len)];
+        if ((kw->len == len) && (SDL_memcmp(kw->str, str, len) == 0)) {
+            return kw->lemon_token;
+        }
+    }
+    return 0;
 }
 
 static int convert_to_lemon_token(Context *ctx, const char *token, size_t tokenlen, const Token tokenval, TokenData *data)
 {
-    data->i64 = 0;
+    data->where.filename = ast_filename(ctx);
+    data->where.line = ctx->position;
+    data->where.position = ctx->source_position;
+    data->value.i64 = 0;
+
+    if ((((size_t) tokenval) < SDL_arraysize(lemon_token_map)) && (lemon_token_map[tokenval] != 0)) {
+        return lemon_token_map[tokenval];
+    }
 
     switch (tokenval) {
         case ((Token) TOKEN_INT_LITERAL):
-            data->i64 = strtoi64(token, tokenlen);
+            if (!strtoi64(token, tokenlen, &data->value.i64)) {
+                fail(ctx, "Invalid digit in octal constant");
+            }
             return TOKEN_SDLSL_INT_CONSTANT;
 
         case ((Token) TOKEN_FLOAT_LITERAL):
-            data->dbl = strtodouble(token, tokenlen);
+            data->value.dbl = strtodouble(token, tokenlen);
             return TOKEN_SDLSL_FLOAT_CONSTANT;
 
         /* The language has no string literals atm!
         case ((Token) TOKEN_STRING_LITERAL):
-            data->string = stringcache_len(ctx->strcache, token, tokenlen);
+            data->value.string = stringcache_len(ctx->strcache, token, tokenlen);
             return TOKEN_SDLSL_STRING_LITERAL;*/
 
-        case ((Token) ','): return TOKEN_SDLSL_COMMA;
-        case ((Token) '='): return TOKEN_SDLSL_ASSIGN;
-        case ((Token) TOKEN_ADDASSIGN): return TOKEN_SDLSL_PLUSASSIGN;
-        case ((Token) TOKEN_SUBASSIGN): return TOKEN_SDLSL_MINUSASSIGN;
-        case ((Token) TOKEN_MULTASSIGN): return TOKEN_SDLSL_STARASSIGN;
-        case ((Token) TOKEN_DIVASSIGN): return TOKEN_SDLSL_SLASHASSIGN;
-        case ((Token) TOKEN_MODASSIGN): return TOKEN_SDLSL_PERCENTASSIGN;
-        case ((Token) TOKEN_LSHIFTASSIGN): return TOKEN_SDLSL_LSHIFTASSIGN;
-        case ((Token) TOKEN_RSHIFTASSIGN): return TOKEN_SDLSL_RSHIFTASSIGN;
-        case ((Token) TOKEN_ANDASSIGN): return TOKEN_SDLSL_ANDASSIGN;
-        case ((Token) TOKEN_ORASSIGN): return TOKEN_SDLSL_ORASSIGN;
-        case ((Token) TOKEN_XORASSIGN): return TOKEN_SDLSL_XORASSIGN;
-        case ((Token) '?'): return TOKEN_SDLSL_QUESTION;
-        case ((Token) TOKEN_OROR): return TOKEN_SDLSL_OROR;
-        case ((Token) TOKEN_ANDAND): return TOKEN_SDLSL_ANDAND;
-        case ((Token) '|'): return TOKEN_SDLSL_OR;
-        case ((Token) '^'): return TOKEN_SDLSL_XOR;
-        case ((Token) '&'): return TOKEN_SDLSL_AND;
-        case ((Token) TOKEN_EQL): return TOKEN_SDLSL_EQL;
-        case ((Token) TOKEN_NEQ): return TOKEN_SDLSL_NEQ;
-        case ((Token) '<'): return TOKEN_SDLSL_LT;
-        case ((Token) TOKEN_LEQ): return TOKEN_SDLSL_LEQ;
-        case ((Token) '>'): return TOKEN_SDLSL_GT;
-        case ((Token) TOKEN_GEQ): return TOKEN_SDLSL_GEQ;
-        case ((Token) TOKEN_LSHIFT): return TOKEN_SDLSL_LSHIFT;
-        case ((Token) TOKEN_RSHIFT): return TOKEN_SDLSL_RSHIFT;
-        case ((Token) '+'): return TOKEN_SDLSL_PLUS;
-        case ((Token) '-'): return TOKEN_SDLSL_MINUS;
-        case ((Token) '*'): return TOKEN_SDLSL_STAR;
-        case ((Token) '/'): return TOKEN_SDLSL_SLASH;
-        case ((Token) '%'): return TOKEN_SDLSL_PERCENT;
-        case ((Token) '!'): return TOKEN_SDLSL_EXCLAMATION;
-        case ((Token) '~'): return TOKEN_SDLSL_COMPLEMENT;
-        case ((Token) TOKEN_DECREMENT): return TOKEN_SDLSL_MINUSMINUS;
-        case ((Token) TOKEN_INCREMENT): return TOKEN_SDLSL_PLUSPLUS;
-        case ((Token) '.'): return TOKEN_SDLSL_DOT;
-        case ((Token) '['): return TOKEN_SDLSL_LBRACKET;
-        case ((Token) ']'): return TOKEN_SDLSL_RBRACKET;
-        case ((Token) '('): return TOKEN_SDLSL_LPAREN;
-        case ((Token) ')'): return TOKEN_SDLSL_RPAREN;
-        case ((Token) ':'): return TOKEN_SDLSL_COLON;
-        case ((Token) ';'): return TOKEN_SDLSL_SEMICOLON;
-        case ((Token) '{'): return TOKEN_SDLSL_LBRACE;
-        case ((Token) '}'): return TOKEN_SDLSL_RBRACE;
-        case ((Token) '@'): return TOKEN_SDLSL_AT;
-
         case ((Token) TOKEN_IDENTIFIER): {
-            const char *str = stringcache_len(ctx->strcache, token, tokenlen);
-            data->string = str;
-            #define tokencmp(t) (SDL_strcmp(data->string, t) == 0)
-            if (tokencmp("function")) return TOKEN_SDLSL_FUNCTION;
-            if (tokencmp("var")) return TOKEN_SDLSL_VAR;
-            if (tokencmp("else")) return TOKEN_SDLSL_ELSE;
-            if (tokencmp("void")) return TOKEN_SDLSL_VOID;
-            if (tokencmp("struct")) return TOKEN_SDLSL_STRUCT;
-            if (tokencmp("break")) return TOKEN_SDLSL_BREAK;
-            if (tokencmp("continue")) return TOKEN_SDLSL_CONTINUE;
-            if (tokencmp("discard")) return TOKEN_SDLSL_DISCARD;
-            if (tokencmp("return")) return TOKEN_SDLSL_RETURN;
-            if (tokencmp("while")) return TOKEN_SDLSL_WHILE;
-            if (tokencmp("for")) return TOKEN_SDLSL_FOR;
-            if (tokencmp("do")) return TOKEN_SDLSL_DO;
-            if (tokencmp("if")) return TOKEN_SDLSL_IF;
-            if (tokencmp("switch")) return TOKEN_SDLSL_SWITCH;
-            if (tokencmp("case")) return TOKEN_SDLSL_CASE;
-            if (tokencmp("default")) return TOKEN_SDLSL_DEFAULT;
-            if (tokencmp("true")) return TOKEN_SDLSL_TRUE;
-            if (tokencmp("false")) return TOKEN_SDLSL_FALSE;
-            #undef tokencmp
+            const int keyword = find_keyword(token, tokenlen);
+            if (keyword != 0) {
+                return keyword;  /* the parser doesn't need a string for these. */
+            }
+            data->value.string = stringcache_len_hash(ctx->strcache, token, tokenlen, preprocessor_tokenhash(ctx));
             return TOKEN_SDLSL_IDENTIFIER;
         }
 
@@ -1026,18 +1101,27 @@ static void parse_sdlsl_source(Context *ctx, const SDL_SHADER_CompilerParams *pa
     int lemon_token;
     TokenData data;
 
+    ctx->ast_filename = ctx->ast_filename_source = NULL;  /* might be stale from a previous run. */
+
+    ctx->memphase = SDL_SHADER_MEMPHASE_PREPROCESS;
     if (!preprocessor_start(ctx, params, SDL_FALSE)) {
         SDL_assert(ctx->isfail);
         SDL_assert(ctx->out_of_memory);  /* shouldn't fail for any other reason. */
         return;
     }
+    ctx->memphase = SDL_SHADER_MEMPHASE_PARSE;
 
-    parser = ParseSDLSLAlloc(ctx->malloc, ctx->malloc_data);
-    if (parser == NULL) {
-        SDL_assert(ctx->isfail);
-        SDL_assert(ctx->out_of_memory);  /* shouldn't fail for any other reason. */
-        return;
+    if (ctx->parser != NULL) {
+        ParseSDLSLInit(ctx->parser);  /* reusable context, already have one from a previous run. */
+    } else {
+        ctx->parser = ParseSDLSLAlloc(MallocContextBridge, ctx);
+        if (ctx->parser == NULL) {
+            SDL_assert(ctx->isfail);
+            SDL_assert(ctx->out_of_memory);  /* shouldn't fail for any other reason. */
+            return;
+        }
     }
+    parser = ctx->parser;
 
     #if DEBUG_COMPILER_PARSER
     ParseSDLSLTrace(stdout, "COMPILER: ");
@@ -1047,7 +1131,9 @@ static void parse_sdlsl_source(Context *ctx, const SDL_SHADER_CompilerParams *pa
     do {
         if (ctx->out_of_memory) { break; }  /* !!! FIXME: I just sprinkled these everywhere, just in case. */
 
+        ctx->memphase = SDL_SHADER_MEMPHASE_PREPROCESS;  /* the parser pulls tokens, so charge the preprocessor for what this allocates. */
         token = preprocessor_nexttoken(ctx, &tokenlen, &tokenval);
+        ctx->memphase = SDL_SHADER_MEMPHASE_PARSE;
         if (ctx->out_of_memory) { break; }
 
         if ((tokenval == TOKEN_HASH) || (tokenval == TOKEN_HASHHASH)) {
@@ -1083,7 +1169,19 @@ static void parse_sdlsl_source(Context *ctx, const SDL_SHADER_CompilerParams *pa
         if (ctx->out_of_memory) { break; }
     } while (tokenval != TOKEN_EOI);
 
-    ParseSDLSLFree(parser, ctx->free, ctx->malloc_data);
+    if (ctx->reusable) {
+        ParseSDLSLFinalize(parser);  /* keep the parser for the next run. */
+    } else {
+        ParseSDLSLFree(parser, FreeContextBridge, ctx);
+        ctx->parser = NULL;
+    }
+
+    /* The tree has copies of everything it needs from the preprocessor now,
+       so release all its state (defines, include stack, filenames, etc)
+       instead of carrying it through semantic analysis and output. */
+    ctx->filename = ast_filename(ctx);
+    preprocessor_end(ctx);
+    ctx->filename = ctx->ast_filename;
 }
 
 
@@ -1095,12 +1193,18 @@ static const SDL_SHADER_AstData SDL_SHADER_out_of_mem_data_ast = {
 static const SDL_SHADER_AstData *build_astdata(Context *ctx)
 {
     SDL_SHADER_AstData *retval = NULL;
+    const size_t error_count = errorlist_count(ctx->errors);
+    SDL_SHADER_Error *errors = NULL;
+    void *unused = NULL;
 
     if (ctx->out_of_memory) {
         return &SDL_SHADER_out_of_mem_data_ast;
     }
 
-    retval = (SDL_SHADER_AstData *) Malloc(ctx, sizeof (SDL_SHADER_AstData));
+    ctx->memphase = SDL_SHADER_MEMPHASE_OUTPUT;
+
+    /* the struct, errors and their strings all go in one block, so the app can free it with one call. */
+    retval = (SDL_SHADER_AstData *) errorlist_flatten(ctx->errors, sizeof (SDL_SHADER_AstData), 0, &errors, &unused);
     if (retval == NULL) {
         return &SDL_SHADER_out_of_mem_data_ast;
     }
@@ -1109,12 +1213,8 @@ static const SDL_SHADER_AstData *build_astdata(Context *ctx)
     retval->malloc = (ctx->malloc == SDL_SHADER_internal_malloc) ? NULL : ctx->malloc;
     retval->free = (ctx->free == SDL_SHADER_internal_free) ? NULL : ctx->free;
     retval->malloc_data = ctx->malloc_data;
-    retval->error_count = errorlist_count(ctx->errors);
-    retval->errors = errorlist_flatten(ctx->errors);
-    if (ctx->out_of_memory) {
-        Free(ctx, retval);
-        return &SDL_SHADER_out_of_mem_data_ast;
-    }
+    retval->error_count = error_count;
+    retval->errors = errors;
 
     if (!ctx->isfail) {
         retval->source_profile = ctx->source_profile;
@@ -1122,6 +1222,8 @@ static const SDL_SHADER_AstData *build_astdata(Context *ctx)
         retval->opaque = ctx;
     }
 
+    retval->memory = ctx->memstats;
+
     return retval;
 }
 
@@ -1145,30 +1247,62 @@ static void choose_src_profile(Context *ctx, const char *srcprofile)
 
 void ast_end(Context *ctx)
 {
-    if (!ctx || !ctx->uses_ast) {
+    if (!ctx) {
         return;
     }
 
-    delete_shader(ctx, ctx->shader);
-
-    stringcache_destroy(ctx->strcache);
+    if (ctx->uses_ast) {
+        /* the whole tree lives in the arena, so this frees every node at once. */
+        if (ctx->reusable) {
+            arena_reset(ctx->ast_arena);
+            stringcache_reset(ctx->strcache);  /* nothing outlives the tree that points into this. */
+        }
+        ctx->shader = NULL;
+        ctx->uses_ast = SDL_FALSE;
+    }
 
-    ctx->uses_ast = SDL_FALSE;
+    /* reusable contexts keep the memory of the arena and string cache, and the parser, for the next run. */
+    if (!ctx->reusable) {
+        arena_destroy(ctx->ast_arena);
+        stringcache_destroy(ctx->strcache);
+        ParseSDLSLFree(ctx->parser, FreeContextBridge, ctx);
+        ctx->ast_arena = NULL;
+        ctx->strcache = NULL;
+        ctx->parser = NULL;
+    }
 }
 
 
-Context *parse_to_ast(const SDL_SHADER_CompilerParams *params)
+Context *parse_to_ast(Context *ctx, const SDL_SHADER_CompilerParams *params)
 {
-    Context *ctx = context_create(params->allocate, params->deallocate, params->allocate_data);
-    if (ctx == NULL) {
-        return NULL;
+    const SDL_bool created = (ctx == NULL) ? SDL_TRUE : SDL_FALSE;
+
+    if (created) {
+        ctx = context_create_from_params(params);
+        if (ctx == NULL) {
+            return NULL;
+        }
     }
 
     ctx->uses_ast = SDL_TRUE;
-    ctx->strcache = stringcache_create(MallocContextBridge, FreeContextBridge, ctx);
+    ctx->memphase = SDL_SHADER_MEMPHASE_PARSE;
+
+    /* a reusable context might already have these from a previous run. */
     if (!ctx->strcache) {
-        context_destroy(ctx);
-        return NULL;
+        ctx->strcache = stringcache_create(MallocContextBridge, FreeContextBridge, ctx);
+    }
+
+    if (!ctx->ast_arena) {
+        ctx->ast_arena = arena_create(AST_ARENA_CHUNK_SIZE, MallocContextBridge, FreeContextBridge, ctx);
+    }
+
+    if (!ctx->strcache || !ctx->ast_arena) {
+        if (created) {
+            context_destroy(ctx);
+            return NULL;
+        }
+        SDL_assert(ctx->out_of_memory);
+        return ctx;
     }
 
     choose_src_profile(ctx, params->srcprofile);
@@ -1189,7 +1323,7 @@ Context *parse_to_ast(const SDL_SHADER_CompilerParams *params)
 const SDL_SHADER_AstData *SDL_SHADER_ParseAst(const SDL_SHADER_CompilerParams *params)
 {
     const SDL_SHADER_AstData *retval = NULL;
-    Context *ctx = parse_to_ast(params);
+    Context *ctx = parse_to_ast(NULL, params);
     if (ctx == NULL) {
         return &SDL_SHADER_out_of_mem_data_ast;
     } else {
@@ -1212,18 +1346,11 @@ void SDL_SHADER_FreeAstData(const SDL_SHADER_AstData *_data)
         Context *ctx = (Context *) data->opaque;
         SDL_SHADER_Free f = (data->free == NULL) ? SDL_SHADER_internal_free : data->free;
         void *d = data->malloc_data;
-        int i;
 
         /* we don't f(data->source_profile), because that's internal static data. */
 
-        for (i = 0; i < data->error_count; i++) {
-            f((void *) data->errors[i].message, d);
-            f((void *) data->errors[i].filename, d);
-        }
-        f((void *) data->errors, d);
-
         /* don't delete data->ast (it'll delete with the context). */
-        f(data, d);
+        FreeReturnedData(f, d, data);  /* errors are in the same block. */
 
         context_destroy(ctx);  /* finally safe to destroy this. */
     }
@@ -145,7 +145,7 @@ typedef struct SDL_SHADER_AstNodeInfo
     SDL_SHADER_AstNodeType type;
     const char *filename;
     size_t line;
-    /* !!! FIXME: position */
+    size_t position;  /* where in the source this node came from; errors about this node use it to report a column. */
     const SDL_SHADER_AstDataType *dt;  /* this is NULL for everything before semantic analysis. Not every node has a datatype. */
 } SDL_SHADER_AstNodeInfo;
 
@@ -597,6 +597,11 @@ typedef struct SDL_SHADER_AstData
      * This is internal data, and not for the application to touch.
      */
     void *opaque;
+
+    /*
+     * How much memory parsing took.
+     */
+    SDL_SHADER_MemoryStats memory;
 } SDL_SHADER_AstData;
 
 
@@ -643,10 +648,16 @@ typedef struct SDL_SHADER_AstData
  *
  * As parsing requires some memory to be allocated, you may provide a
  *  custom allocator to this function, which will be used to allocate/free
- *  memory. They function just like malloc() and free(). We do not use
- *  realloc(). If you don't care, pass NULL in for the allocator functions.
- *  If your allocator needs instance-specific data, you may supply it with the
- *  (d) parameter. This pointer is passed as-is to your (m) and (f) functions.
+ *  memory. They function just like malloc() and free(). If you don't care,
+ *  pass NULL in for the allocator functions. If your allocator needs
+ *  instance-specific data, you may supply it with the (d) parameter. This
+ *  pointer is passed as-is to your (m) and (f) functions.
+ *
+ * If you supply a custom allocator, you can also supply (reallocate), which
+ *  we use to grow arrays, and (sized_deallocate), which we use instead of
+ *  (deallocate) for freeing our internal memory. Either can be NULL. Returned
+ *  data is always freed with (deallocate), so all of these must work on the
+ *  same heap.
  *
  * This function is thread safe, so long as the various callback functions
  *  are, too, and that the parameters remains intact for the duration of the
@@ -26,17 +26,48 @@ SDL_SHADER_Error SDL_SHADER_out_of_mem_error = {
     SDL_TRUE, "Out of memory", NULL, SDL_SHADER_POSITION_NONE
 };
 
+typedef union ArenaAlignment  /* we align allocations to fit any of these. */
+{
+    Sint64 i64;
+    double dbl;
+    void *ptr;
+} ArenaAlignment;
+
+#define ARENA_ALIGN(x) (((x) + (sizeof (ArenaAlignment) - 1)) & ~(sizeof (ArenaAlignment) - 1))
+
+/* Hash tables come in two flavors behind the same API. Stackable tables
+   chain items in buckets, since they need to keep duplicate keys around in
+   the order they were inserted. Everything else uses open addressing with
+   linear probing, which means no allocation per item and lookups that walk
+   a contiguous array. Both flavors keep the full hash of each item (so we
+   can rehash without calling back into the app and skip most keymatch
+   calls), and both grow when they get too full. */
+
+#define HASHTABLE_INITIAL_SIZE 256
+
 typedef struct HashItem
 {
     const void *key;
     const void *value;
+    Uint32 hash;
     struct HashItem *next;
 } HashItem;
 
+typedef struct HashSlot
+{
+    const void *key;
+    const void *value;
+    Uint32 hash;
+    SDL_bool used;
+} HashSlot;
+
 struct HashTable
 {
-    HashItem **table;
+    HashItem **table;  /* only used by stackable tables. */
+    MemPool *item_pool;  /* HashItems for stackable tables come from here. */
+    HashSlot *slots;  /* only used by non-stackable tables. */
     Uint32 table_len;
+    Uint32 count;
     SDL_bool stackable;
     void *data;
     HashTable_HashFn hash;
@@ -47,35 +78,46 @@ struct HashTable
     void *d;
 };
 
-static inline Uint32 calc_hash(const HashTable *table, const void *key)
+/* returns the slot holding `key`, or the empty slot that ends its probe sequence. */
+static Uint32 hash_probe(const HashTable *table, const void *key, const Uint32 hash)
 {
-    return table->hash(key, table->data) & (table->table_len-1);
+    const Uint32 mask = table->table_len - 1;
+    const HashSlot *slots = table->slots;
+    Uint32 idx = hash & mask;
+    while (slots[idx].used) {
+        if ((slots[idx].hash == hash) && table->keymatch(key, slots[idx].key, table->data)) {
+            break;
+        }
+        idx = (idx + 1) & mask;
+    }
+    return idx;
 }
 
 SDL_bool hash_find(const HashTable *table, const void *key, const void **_value)
 {
     HashItem *i;
     void *data = table->data;
-    const Uint32 hash = calc_hash(table, key);
-    HashItem *prev = NULL;
-    for (i = table->table[hash]; i != NULL; i = i->next) {
-        if (table->keymatch(key, i->key, data)) {
+    const Uint32 hash = table->hash(key, data);
+    Uint32 idx;
+
+    if (!table->stackable) {
+        const HashSlot *slot = &table->slots[hash_probe(table, key, hash)];
+        if (!slot->used) {
+            return SDL_FALSE;
+        } else if (_value != NULL) {
+            *_value = slot->value;
+        }
+        return SDL_TRUE;
+    }
+
+    idx = hash & (table->table_len-1);
+    for (i = table->table[idx]; i != NULL; i = i->next) {
+        if ((i->hash == hash) && table->keymatch(key, i->key, data)) {
             if (_value != NULL) {
                 *_value = i->value;
             }
-
-            /* Matched! Move to the front of list for faster lookup next time. (stackable tables have to remain in the same order, though!) */
-            if ((!table->stackable) && (prev != NULL)) {
-                SDL_assert(prev->next == i);
-                prev->next = i->next;
-                i->next = table->table[hash];
-                table->table[hash] = i;
-            }
-
-            return SDL_TRUE;
+            return SDL_TRUE;  /* (stackable tables have to remain in the same order, so we don't move this to the front.) */
         }
-
-        prev = i;
     }
 
     return SDL_FALSE;
@@ -83,9 +125,26 @@ SDL_bool hash_find(const HashTable *table, const void *key, const void **_value)
 
 SDL_bool hash_iter(const HashTable *table, const void *key, const void **_value, void **iter)
 {
-    HashItem *item = (*iter == NULL) ? table->table[calc_hash(table, key)] : ((HashItem *) *iter)->next;
+    const Uint32 hash = table->hash(key, table->data);
+    HashItem *item;
+
+    if (!table->stackable) {  /* no duplicates, so there's only ever one match. */
+        if (*iter == NULL) {
+            const Uint32 idx = hash_probe(table, key, hash);
+            if (table->slots[idx].used) {
+                *_value = table->slots[idx].value;
+                *iter = (void *) (size_t) (idx + 1);
+                return SDL_TRUE;
+            }
+        }
+        *_value = NULL;
+        *iter = NULL;
+        return SDL_FALSE;
+    }
+
+    item = (*iter == NULL) ? table->table[hash & (table->table_len-1)] : ((HashItem *) *iter)->next;
     while (item != NULL) {
-        if (table->keymatch(key, item->key, table->data)) {
+        if ((item->hash == hash) && table->keymatch(key, item->key, table->data)) {
             *_value = item->value;
             *iter = item;
             return SDL_TRUE;
@@ -104,11 +163,24 @@ SDL_bool hash_iter_keys(const HashTable *table, const void **_key, void **iter)
     HashItem *item = (HashItem *) *iter;
     Uint32 idx = 0;
 
+    if (!table->stackable) {  /* iter is the index of the last slot we reported, plus one. */
+        for (idx = (Uint32) (size_t) *iter; idx < table->table_len; idx++) {
+            if (table->slots[idx].used) {
+                *_key = table->slots[idx].key;
+                *iter = (void *) (size_t) (idx + 1);
+                return SDL_TRUE;
+            }
+        }
+        *_key = NULL;
+        *iter = NULL;
+        return SDL_FALSE;
+    }
+
     if (item != NULL) {
         const HashItem *orig = item;
         item = item->next;
         if (item == NULL) {
-            idx = calc_hash(table, orig->key) + 1;
+            idx = (orig->hash & (table->table_len-1)) + 1;
         }
     }
 
@@ -127,24 +199,111 @@ SDL_bool hash_iter_keys(const HashTable *table, const void **_key, void **iter)
     return SDL_TRUE;
 }
 
+static SDL_bool hash_grow(HashTable *table)
+{
+    const Uint32 old_len = table->table_len;
+    const Uint32 new_len = old_len * 2;
+    Uint32 i;
+
+    if (!table->stackable) {
+        const size_t alloc_len = sizeof (HashSlot) * new_len;
+        HashSlot *old_slots = table->slots;
+        HashSlot *slots = (HashSlot *) table->m(alloc_len, table->d);
+        if (slots == NULL) {
+            return SDL_FALSE;
+        }
+
+        SDL_memset(slots, '\0', alloc_len);
+        for (i = 0; i < old_len; i++) {
+            if (old_slots[i].used) {
+                Uint32 idx = old_slots[i].hash & (new_len-1);
+                while (slots[idx].used) {
+                    idx = (idx + 1) & (new_len-1);
+                }
+                slots[idx] = old_slots[i];
+            }
+        }
+        table->f(old_slots, table->d);
+        table->slots = slots;
+    } else {
+        const size_t alloc_len = sizeof (HashItem *) * new_len;
+        HashItem **old_table = table->table;
+        HashItem **newtable = (HashItem **) table->m(alloc_len, table->d);
+        if (newtable == NULL) {
+            return SDL_FALSE;
+        }
+
+        /* Each old bucket splits into bucket `i` and bucket `i + old_len`.
+           Append in order, so duplicate keys keep their stacking order. */
+        for (i = 0; i < old_len; i++) {
+            HashItem **lo = &newtable[i];
+            HashItem **hi = &newtable[i + old_len];
+            HashItem *item = old_table[i];
+            while (item != NULL) {
+                if (item->hash & old_len) {
+                    *hi = item;
+                    hi = &item->next;
+                } else {
+                    *lo = item;
+                    lo = &item->next;
+                }
+                item = item->next;
+            }
+            *lo = NULL;
+            *hi = NULL;
+        }
+        table->f(old_table, table->d);
+        table->table = newtable;
+    }
+
+    table->table_len = new_len;
+    return SDL_TRUE;
+}
+
 int hash_insert(HashTable *table, const void *key, const void *value)
 {
     HashItem *item = NULL;
-    const Uint32 hash = calc_hash(table, key);
-    if ( (!table->stackable) && (hash_find(table, key, NULL)) ) {
-        return 0;
+    const Uint32 hash = table->hash(key, table->data);
+    Uint32 idx;
+
+    if (!table->stackable) {
+        idx = hash_probe(table, key, hash);
+        if (table->slots[idx].used) {
+            return 0;
+        }
+
+        /* keep the load factor under 3/4, so probe sequences stay short. */
+        if (((table->count + 1) * 4) > (table->table_len * 3)) {
+            if (!hash_grow(table)) {
+                return -1;
+            }
+            idx = hash_probe(table, key, hash);
+        }
+
+        table->slots[idx].key = key;
+        table->slots[idx].value = value;
+        table->slots[idx].hash = hash;
+        table->slots[idx].used = SDL_TRUE;
+        table->count++;
+        return 1;
     }
 
-    /* !!! FIXME: grow and rehash table if it gets too saturated. */
-    item = (HashItem *) table->m(sizeof (HashItem), table->d);
+    item = (HashItem *) pool_alloc(table->item_pool);
     if (item == NULL) {
         return -1;
     }
 
+    if (table->count >= table->table_len) {
+        hash_grow(table);  /* if this fails, we just live with longer chains. */
+    }
+
+    idx = hash & (table->table_len-1);
     item->key = key;
     item->value = value;
-    item->next = table->table[hash];
-    table->table[hash] = item;
+    item->hash = hash;
+    item->next = table->table[idx];
+    table->table[idx] = item;
+    table->count++;
 
     return 1;
 }
@@ -155,21 +314,33 @@ HashTable *hash_create(void *data, const HashTable_HashFn hashfn,
               const SDL_bool stackable,
               SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
 {
-    const Uint32 initial_table_size = 256;
-    const Uint32 alloc_len = sizeof (HashItem *) * initial_table_size;
+    const Uint32 initial_table_size = HASHTABLE_INITIAL_SIZE;
+    const Uint32 alloc_len = (stackable ? sizeof (HashItem *) : sizeof (HashSlot)) * initial_table_size;
+    void *buckets;
     HashTable *table = (HashTable *) m(sizeof (HashTable), d);
     if (table == NULL) {
         return NULL;
     }
     SDL_zerop(table);
 
-    table->table = (HashItem **) m(alloc_len, d);
-    if (table->table == NULL) {
+    buckets = m(alloc_len, d);
+    if (buckets == NULL) {
         f(table, d);
         return NULL;
     }
 
-    SDL_memset(table->table, '\0', alloc_len);
+    SDL_memset(buckets, '\0', alloc_len);
+    if (stackable) {
+        table->table = (HashItem **) buckets;
+        table->item_pool = pool_create(sizeof (HashItem), m, f, d);
+        if (table->item_pool == NULL) {
+            f(buckets, d);
+            f(table, d);
+            return NULL;
+        }
+    } else {
+        table->slots = (HashSlot *) buckets;
+    }
     table->table_len = initial_table_size;
     table->stackable = stackable;
     table->data = data;
@@ -188,16 +359,26 @@ void hash_destroy(HashTable *table)
     void *data = table->data;
     SDL_SHADER_Free f = table->f;
     void *d = table->d;
+
+    if (!table->stackable) {
+        for (i = 0; i < table->table_len; i++) {
+            if (table->slots[i].used) {
+                table->nuke(table->slots[i].key, table->slots[i].value, data);
+            }
+        }
+        f(table->slots, d);
+        f(table, d);
+        return;
+    }
+
     for (i = 0; i < table->table_len; i++) {
-        HashItem *item = table->table[i];
-        while (item != NULL) {
-            HashItem *next = item->next;
+        HashItem *item;
+        for (item = table->table[i]; item != NULL; item = item->next) {
             table->nuke(item->key, item->value, data);
-            f(item, d);
-            item = next;
         }
     }
 
+    pool_destroy(table->item_pool);  /* this frees all the HashItems at once. */
     f(table->table, d);
     f(table, d);
 }
@@ -207,16 +388,53 @@ SDL_bool hash_remove(HashTable *table, const void *key)
     HashItem *item = NULL;
     HashItem *prev = NULL;
     void *data = table->data;
-    const Uint32 hash = calc_hash(table, key);
-    for (item = table->table[hash]; item != NULL; item = item->next) {
-        if (table->keymatch(key, item->key, data)) {
+    const Uint32 hash = table->hash(key, data);
+    Uint32 idx;
+
+    if (!table->stackable) {
+        const Uint32 mask = table->table_len - 1;
+        HashSlot *slots = table->slots;
+        Uint32 i = hash_probe(table, key, hash);
+        Uint32 j = i;
+
+        if (!slots[i].used) {
+            return SDL_FALSE;
+        }
+
+        table->nuke(slots[i].key, slots[i].value, data);
+        table->count--;
+
+        /* Shift later items in this run back into the hole, so we don't
+           need tombstones. An item only moves if its home slot isn't
+           cyclically between the hole and where it sits now. */
+        while (SDL_TRUE) {
+            Uint32 home;
+            j = (j + 1) & mask;
+            if (!slots[j].used) {
+                break;
+            }
+            home = slots[j].hash & mask;
+            if ((i <= j) ? ((i < home) && (home <= j)) : ((i < home) || (home <= j))) {
+                continue;
+            }
+            slots[i] = slots[j];
+            i = j;
+        }
+        slots[i].used = SDL_FALSE;
+        return SDL_TRUE;
+    }
+
+    idx = hash & (table->table_len-1);
+    for (item = table->table[idx]; item != NULL; item = item->next) {
+        if ((item->hash == hash) && table->keymatch(key, item->key, data)) {
             if (prev != NULL) {
                 prev->next = item->next;
             } else {
-                table->table[hash] = item->next;
+                table->table[idx] = item->next;
             }
             table->nuke(item->key, item->value, data);
-            table->f(item, table->d);
+            pool_free(table->item_pool, item);
+            table->count--;
             return SDL_TRUE;
         }
 
@@ -226,7 +444,6 @@ SDL_bool hash_remove(HashTable *table, const void *key)
     return SDL_FALSE;
 }
 
-/* !!! FIXME: this is in another source file too! */
 /* this is djb's xor hashing function. */
 static inline Uint32 hash_string_djbxor(const char *str, size_t len)
 {
@@ -237,7 +454,7 @@ static inline Uint32 hash_string_djbxor(const char *str, size_t len)
     return hash;
 }
 
-static inline Uint32 hash_string(const char *str, size_t len)
+Uint32 hash_string(const char *str, size_t len)
 {
     return hash_string_djbxor(str, len);
 }
@@ -329,16 +546,39 @@ SDL_bool stringmap_find(const StringMap *smap, const char *key, const char **_va
 
 /* The string cache...   !!! FIXME: use StringMap internally for this. */
 
+/* Strings never leave the cache until it's destroyed, so we pack the buckets
+   and their strings into a memory arena instead of allocating each one. */
+#define STRINGCACHE_CHUNK_SIZE (8 * 1024)
+
+/* We keep the full hash of each string so we can rehash without touching
+   the string bytes, and so lookups can reject most mismatches without a
+   memcmp. The table doubles when it gets more entries than buckets. */
+#define STRINGCACHE_INITIAL_TABLE_SIZE 256
+
 typedef struct StringBucket
 {
     char *string;
+    Uint32 hash;
+    Uint32 id;
+    size_t len;
     struct StringBucket *next;
 } StringBucket;
 
+/* Cached strings always sit right after their bucket in memory, so we can
+   get from an atom back to its metadata without a lookup. */
+static inline const StringBucket *atom_bucket(const char *atom)
+{
+    const StringBucket *bucket = ((const StringBucket *) atom) - 1;
+    SDL_assert(bucket->string == atom);
+    return bucket;
+}
+
 struct StringCache
 {
     StringBucket **hashtable;
     Uint32 table_size;
+    Uint32 count;
+    MemArena *arena;  /* buckets and string bytes are packed in here. */
     SDL_SHADER_Malloc m;
     SDL_SHADER_Free f;
     void *d;
@@ -350,20 +590,48 @@ const char *stringcache(StringCache *cache, const char *str)
     return stringcache_len(cache, str, strlen(str));
 }
 
-static const char *stringcache_len_internal(StringCache *cache, const char *str, const size_t len, const SDL_bool addmissing)
+static void stringcache_grow(StringCache *cache)
+{
+    const Uint32 new_size = cache->table_size * 2;
+    const size_t tablelen = sizeof (StringBucket *) * new_size;
+    StringBucket **table = (StringBucket **) cache->m(tablelen, cache->d);
+    Uint32 i;
+
+    if (table == NULL) {
+        return;  /* oh well, keep going with longer chains. */
+    }
+
+    SDL_memset(table, '\0', tablelen);
+    for (i = 0; i < cache->table_size; i++) {
+        StringBucket *bucket = cache->hashtable[i];
+        while (bucket) {
+            StringBucket *next = bucket->next;
+            const Uint32 idx = bucket->hash & (new_size-1);
+            bucket->next = table[idx];
+            table[idx] = bucket;
+            bucket = next;
+        }
+    }
+
+    cache->f(cache->hashtable, cache->d);
+    cache->hashtable = table;
+    cache->table_size = new_size;
+}
+
+static const char *stringcache_len_internal(StringCache *cache, const char *str, const size_t len, const Uint32 hash, const SDL_bool addmissing)
 {
-    const Uint8 hash = hash_string(str, len) & (cache->table_size-1);
-    StringBucket *bucket = cache->hashtable[hash];
+    Uint32 idx = hash & (cache->table_size-1);
+    StringBucket *bucket = cache->hashtable[idx];
     StringBucket *prev = NULL;
     while (bucket) {
         const char *bstr = bucket->string;
-        if ((SDL_strncmp(bstr, str, len) == 0) && (bstr[len] == 0)) {
+        if ((bucket->hash == hash) && (bucket->len == len) && (SDL_memcmp(bstr, str, len) == 0)) {
             /* Matched! Move this to the front of the list. */
             if (prev != NULL) {
                 SDL_assert(prev->next == bucket);
                 prev->next = bucket->next;
-                bucket->next = cache->hashtable[hash];
-                cache->hashtable[hash] = bucket;
+                bucket->next = cache->hashtable[idx];
+                cache->hashtable[idx] = bucket;
             }
             return bstr; /* already cached */
         }
@@ -377,27 +645,77 @@ static const char *stringcache_len_internal(StringCache *cache, const char *str,
     }
 
     /* add to the table. */
-    bucket = (StringBucket *) cache->m(sizeof (StringBucket) + len + 1, cache->d);
+    bucket = (StringBucket *) arena_alloc(cache->arena, sizeof (StringBucket) + len + 1);
     if (bucket == NULL) {
         return NULL;
     }
 
+    if (cache->count >= cache->table_size) {
+        stringcache_grow(cache);
+        idx = hash & (cache->table_size-1);
+    }
+
     bucket->string = (char *)(bucket + 1);
     SDL_memcpy(bucket->string, str, len);
     bucket->string[len] = '\0';
-    bucket->next = cache->hashtable[hash];
-    cache->hashtable[hash] = bucket;
+    bucket->hash = hash;
+    bucket->id = ++cache->count;  /* ids start at 1, so 0 can mean "no atom". */
+    bucket->len = len;
+    bucket->next = cache->hashtable[idx];
+    cache->hashtable[idx] = bucket;
     return bucket->string;
 }
 
 const char *stringcache_len(StringCache *cache, const char *str, const size_t len)
 {
-    return stringcache_len_internal(cache, str, len, SDL_TRUE);
+    return stringcache_len_internal(cache, str, len, hash_string(str, len), SDL_TRUE);
+}
+
+const char *stringcache_len_hash(StringCache *cache, const char *str, const size_t len, const Uint32 hash)
+{
+    SDL_assert(hash == hash_string(str, len));
+    return stringcache_len_internal(cache, str, len, hash, SDL_TRUE);
 }
 
 SDL_bool stringcache_iscached(StringCache *cache, const char *str)
 {
-    return (stringcache_len_internal(cache, str, SDL_strlen(str), SDL_FALSE) != NULL) ? SDL_TRUE : SDL_FALSE;
+    const size_t len = SDL_strlen(str);
+    return (stringcache_len_internal(cache, str, len, hash_string(str, len), SDL_FALSE) != NULL) ? SDL_TRUE : SDL_FALSE;
+}
+
+Uint32 stringcache_atom_id(const char *atom)
+{
+    return atom ? atom_bucket(atom)->id : 0;
+}
+
+Uint32 stringcache_atom_hash(const char *atom)
+{
+    return atom ? atom_bucket(atom)->hash : 0;
+}
+
+size_t stringcache_atom_len(const char *atom)
+{
+    return atom ? atom_bucket(atom)->len : 0;
+}
+
+Uint32 hash_hash_atom(const void *sym, void *data)
+{
+    (void) data;
+    return stringcache_atom_hash((const char *) sym);
+}
+
+int hash_keymatch_atom(const void *a, const void *b, void *data)
+{
+    (void) data;
+    return a == b;
+}
+
+int hash_keymatch_atom_any_cache(const void *a, const void *b, void *data)
+{
+    /* atoms from different caches have the same hash but not the same pointer. */
+    const size_t len = stringcache_atom_len((const char *) a);
+    (void) data;
+    return (a == b) || ((len == stringcache_atom_len((const char *) b)) && (SDL_memcmp(a, b, len) == 0));
 }
 
 const char *stringcache_fmt(StringCache *cache, const char *fmt, ...)
@@ -431,7 +749,7 @@ const char *stringcache_fmt(StringCache *cache, const char *fmt, ...)
 
 StringCache *stringcache_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
 {
-    const Uint32 initial_table_size = 256;
+    const Uint32 initial_table_size = STRINGCACHE_INITIAL_TABLE_SIZE;
     const size_t tablelen = sizeof (StringBucket *) * initial_table_size;
     StringCache *cache = (StringCache *) m(sizeof (StringCache), d);
     if (!cache) {
@@ -446,6 +764,13 @@ StringCache *stringcache_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
     }
     SDL_memset(cache->hashtable, '\0', tablelen);
 
+    cache->arena = arena_create(STRINGCACHE_CHUNK_SIZE, m, f, d);
+    if (!cache->arena) {
+        f(cache->hashtable, d);
+        f(cache, d);
+        return NULL;
+    }
+
     cache->table_size = initial_table_size;
     cache->m = m;
     cache->f = f;
@@ -453,23 +778,21 @@ StringCache *stringcache_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
     return cache;
 }
 
+void stringcache_reset(StringCache *cache)
+{
+    if (cache != NULL) {
+        arena_reset(cache->arena);  /* this drops every bucket and string at once. */
+        SDL_memset(cache->hashtable, '\0', sizeof (StringBucket *) * cache->table_size);
+        cache->count = 0;
+    }
+}
+
 void stringcache_destroy(StringCache *cache)
 {
     if (cache != NULL) {
         SDL_SHADER_Free f = cache->f;
         void *d = cache->d;
-        size_t i;
-
-        for (i = 0; i < cache->table_size; i++) {
-            StringBucket *bucket = cache->hashtable[i];
-            cache->hashtable[i] = NULL;
-            while (bucket)  {
-                StringBucket *next = bucket->next;
-                f(bucket, d);
-                bucket = next;
-            }
-        }
-
+        arena_destroy(cache->arena);  /* this frees every bucket and string at once. */
         f(cache->hashtable, d);
         f(cache, d);
     }
@@ -477,7 +800,11 @@ void stringcache_destroy(StringCache *cache)
 
 
 /* We chain errors as a linked list with a head/tail for easy appending.
-   These get flattened before passing to the application. */
+   These get flattened before passing to the application. Filenames are
+   interned in the list's own StringCache, since one bad header can make
+   thousands of errors that all name the same file; we also keep each
+   distinct filename in order of its atom id, so flattening can copy each
+   one into the results just once. */
 typedef struct ErrorItem
 {
     SDL_SHADER_Error error;
@@ -489,18 +816,81 @@ struct ErrorList
     ErrorItem head;
     ErrorItem *tail;
     size_t count;
+    MemPool *item_pool;
+    StringCache *filename_cache;  /* created when the first error with a filename shows up. */
+    const char **filenames;  /* filenames[id-1] is the interned filename with that atom id. */
+    Uint32 num_filenames;
+    Uint32 filenames_allocated;
     SDL_SHADER_Malloc m;
+    SDL_SHADER_Realloc r;
     SDL_SHADER_Free f;
     void *d;
 };
 
-ErrorList *errorlist_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
+static const char *errorlist_intern_filename(ErrorList *list, const char *fname)
+{
+    const char *retval;
+    Uint32 id;
+
+    if (list->filename_cache == NULL) {
+        list->filename_cache = stringcache_create(list->m, list->f, list->d);
+        if (list->filename_cache == NULL) {
+            return NULL;
+        }
+    }
+
+    /* make sure there's room for a new filename first, so ids and array slots can't get out of sync. */
+    if (list->num_filenames >= list->filenames_allocated) {
+        const Uint32 newalloc = list->filenames_allocated ? (list->filenames_allocated * 2) : 8;
+        const size_t oldlen = sizeof (const char *) * list->filenames_allocated;
+        const size_t newlen = sizeof (const char *) * newalloc;
+        const char **ptr;
+        if (list->filenames && list->r) {
+            ptr = (const char **) list->r((void *) list->filenames, oldlen, newlen, list->d);
+            if (ptr == NULL) {
+                return NULL;
+            }
+        } else {
+            ptr = (const char **) list->m(newlen, list->d);
+            if (ptr == NULL) {
+                return NULL;
+            }
+            if (list->filenames) {
+                SDL_memcpy(ptr, list->filenames, sizeof (const char *) * list->num_filenames);
+                list->f(list->filenames, list->d);
+            }
+        }
+        list->filenames = ptr;
+        list->filenames_allocated = newalloc;
+    }
+
+    retval = stringcache(list->filename_cache, fname);
+    if (retval == NULL) {
+        return NULL;
+    }
+
+    id = stringcache_atom_id(retval);
+    if (id > list->num_filenames) {  /* haven't seen this one before. */
+        SDL_assert(id == (list->num_filenames + 1));
+        list->filenames[list->num_filenames++] = retval;
+    }
+
+    return retval;
+}
+
+ErrorList *errorlist_create(SDL_SHADER_Malloc m, SDL_SHADER_Realloc r, SDL_SHADER_Free f, void *d)
 {
     ErrorList *retval = (ErrorList *) m(sizeof (ErrorList), d);
     if (retval != NULL) {
         SDL_zerop(retval);
+        retval->item_pool = pool_create(sizeof (ErrorItem), m, f, d);
+        if (retval->item_pool == NULL) {
+            f(retval, d);
+            return NULL;
+        }
         retval->tail = &retval->head;
         retval->m = m;
+        retval->r = r;
         retval->f = f;
         retval->d = d;
     }
@@ -508,27 +898,27 @@ ErrorList *errorlist_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
     return retval;
 }
 
-SDL_bool errorlist_add(ErrorList *list, const SDL_bool is_error, const char *fname, const int errpos, const char *str)
+SDL_bool errorlist_add(ErrorList *list, const SDL_bool is_error, const char *fname, const int errpos, const int errcol, const char *str)
 {
-    return errorlist_add_fmt(list, is_error, fname, errpos, "%s", str);
+    return errorlist_add_fmt(list, is_error, fname, errpos, errcol, "%s", str);
 }
 
 
-SDL_bool errorlist_add_fmt(ErrorList *list, const SDL_bool is_error, const char *fname, const int errpos, const char *fmt, ...)
+SDL_bool errorlist_add_fmt(ErrorList *list, const SDL_bool is_error, const char *fname, const int errpos, const int errcol, const char *fmt, ...)
 {
     size_t retval;
     va_list ap;
     va_start(ap, fmt);
-    retval = errorlist_add_va(list, is_error, fname, errpos, fmt, ap);
+    retval = errorlist_add_va(list, is_error, fname, errpos, errcol, fmt, ap);
     va_end(ap);
     return retval;
 }
 
 
-SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *_fname, const int errpos, const char *fmt, va_list va)
+SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *_fname, const int errpos, const int errcol, const char *fmt, va_list va)
 {
-    ErrorItem *error = (ErrorItem *) list->m(sizeof (ErrorItem), list->d);
-    char *fname = NULL;
+    ErrorItem *error = (ErrorItem *) pool_alloc(list->item_pool);
+    const char *fname = NULL;
     char *failstr;
     char scratch[128];
     size_t len;
@@ -539,12 +929,11 @@ SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *
     }
 
     if (_fname != NULL) {
-        fname = (char *) list->m(SDL_strlen(_fname) + 1, list->d);
+        fname = errorlist_intern_filename(list, _fname);
         if (fname == NULL) {
-            list->f(error, list->d);
+            pool_free(list->item_pool, error);
             return SDL_FALSE;
         }
-        strcpy(fname, _fname);
     }
 
     va_copy(ap, va);
@@ -553,8 +942,7 @@ SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *
 
     failstr = (char *) list->m(len + 1, list->d);
     if (failstr == NULL) {
-        list->f(error, list->d);
-        list->f(fname, list->d);
+        pool_free(list->item_pool, error);
         return SDL_FALSE;
     }
 
@@ -573,6 +961,7 @@ SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *
     error->error.message = failstr;
     error->error.filename = fname;
     error->error.error_position = errpos;
+    error->error.error_column = errcol;
     error->next = NULL;
 
     list->tail->next = error;
@@ -588,32 +977,75 @@ size_t errorlist_count(ErrorList *list)
     return list ? list->count : 0;
 }
 
-SDL_SHADER_Error *errorlist_flatten(ErrorList *list)
+void *errorlist_flatten(ErrorList *list, const size_t structlen, const size_t extralen, SDL_SHADER_Error **_errors, void **_extra)
 {
-    SDL_SHADER_Error *retval = NULL;
-    if (list->count > 0) {
-        ErrorItem *item = list->head.next;
-        size_t total = 0;
-        retval = (SDL_SHADER_Error *) list->m(sizeof (SDL_SHADER_Error) * list->count, list->d);
-        if (retval == NULL) {
-            return NULL;
-        }
+    const size_t errors_offset = ARENA_ALIGN(structlen);
+    const size_t extra_offset = errors_offset + (sizeof (SDL_SHADER_Error) * list->count);
+    const size_t strings_offset = extra_offset + extralen;
+    size_t total = strings_offset;
+    SDL_SHADER_Error *errors;
+    ErrorItem *item;
+    Uint8 *retval;
+    char *str;
+    size_t i;
 
-        while (item != NULL) {
-            ErrorItem *next = item->next;
-            /* reuse the string allocations */
-            SDL_memcpy(&retval[total], &item->error, sizeof (SDL_SHADER_Error));
-            list->f(item, list->d);
-            item = next;
-            total++;
+    /* one pass to size up the strings, one to pack them in. Each distinct
+       filename is only stored once, and every error that names it shares it. */
+    for (item = list->head.next; item != NULL; item = item->next) {
+        total += SDL_strlen(item->error.message) + 1;
+    }
+    for (i = 0; i < list->num_filenames; i++) {
+        total += stringcache_atom_len(list->filenames[i]) + 1;
+    }
+
+    retval = (Uint8 *) list->m(total, list->d);
+    if (retval == NULL) {
+        return NULL;  /* list is left intact. */
+    }
+
+    errors = (SDL_SHADER_Error *) (retval + errors_offset);
+    str = (char *) (retval + strings_offset);
+
+    /* copy the filenames over, and point the list at the copies, since we're about to reset it anyhow. */
+    for (i = 0; i < list->num_filenames; i++) {
+        const size_t len = stringcache_atom_len(list->filenames[i]) + 1;
+        SDL_memcpy(str, list->filenames[i], len);
+        list->filenames[i] = str;
+        str += len;
+    }
+
+    item = list->head.next;
+    for (i = 0; i < list->count; i++) {
+        ErrorItem *next = item->next;
+        size_t len;
+
+        SDL_memcpy(&errors[i], &item->error, sizeof (SDL_SHADER_Error));
+
+        len = SDL_strlen(item->error.message) + 1;
+        SDL_memcpy(str, item->error.message, len);
+        errors[i].message = str;
+        str += len;
+
+        if (item->error.filename) {
+            errors[i].filename = list->filenames[stringcache_atom_id(item->error.filename) - 1];
         }
 
-        SDL_assert(total == list->count);
-        list->count = 0;
-        list->head.next = NULL;
-        list->tail = &list->head;
+        list->f((void *) item->error.message, list->d);
+        pool_free(list->item_pool, item);
+        item = next;
     }
 
+    SDL_assert(item == NULL);
+    SDL_assert(str == (char *) (retval + total));
+
+    list->count = 0;
+    list->head.next = NULL;
+    list->tail = &list->head;
+    list->num_filenames = 0;
+    stringcache_reset(list->filename_cache);
+
+    *_errors = (i > 0) ? errors : NULL;
+    *_extra = (extralen > 0) ? (retval + extra_offset) : NULL;
     return retval;
 }
 
@@ -626,138 +1058,489 @@ void errorlist_destroy(ErrorList *list)
         while (item != NULL) {
             ErrorItem *next = item->next;
             f((void *) item->error.message, d);
-            f((void *) item->error.filename, d);
-            f(item, d);
             item = next;
         }
+        pool_destroy(list->item_pool);
+        stringcache_destroy(list->filename_cache);
+        f(list->filenames, d);
         f(list, d);
     }
 }
 
 
-typedef struct BufferBlock
+/* Memory arenas hand out pieces of large chunks and never free individual
+   allocations; everything goes away at once in arena_destroy(). This is
+   good for things like AST nodes, where we make a ton of small objects
+   that all die together. */
+
+typedef struct ArenaChunk
 {
     Uint8 *data;
     size_t bytes;
-    struct BufferBlock *next;
-} BufferBlock;
+    size_t used;
+    struct ArenaChunk *next;
+} ArenaChunk;
 
-struct Buffer
+struct MemArena
 {
-    size_t total_bytes;
-    BufferBlock *head;
-    BufferBlock *tail;
-    size_t block_size;
+    ArenaChunk *chunks;  /* head is the chunk we're currently carving up. */
+    ArenaChunk *spare;  /* standard-sized chunks kept around by arena_reset(). */
+    size_t chunk_size;
     SDL_SHADER_Malloc m;
     SDL_SHADER_Free f;
     void *d;
 };
 
-Buffer *buffer_create(size_t blksz, SDL_SHADER_Malloc m,
-                      SDL_SHADER_Free f, void *d)
+MemArena *arena_create(size_t chunksz, SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
 {
-    Buffer *buffer = (Buffer *) m(sizeof (Buffer), d);
-    if (buffer != NULL) {
-        SDL_zerop(buffer);
-        buffer->block_size = blksz;
-        buffer->m = m;
-        buffer->f = f;
-        buffer->d = d;
+    MemArena *arena = (MemArena *) m(sizeof (MemArena), d);
+    if (arena != NULL) {
+        SDL_zerop(arena);
+        arena->chunk_size = chunksz;
+        arena->m = m;
+        arena->f = f;
+        arena->d = d;
     }
-    return buffer;
+    return arena;
 }
 
-char *buffer_reserve(Buffer *buffer, const size_t len)
+void *arena_alloc(MemArena *arena, const size_t _len)
 {
-    /* note that we make the blocks bigger than blocksize when we have enough
-       data to overfill a fresh block, to reduce allocations. */
-    const size_t blocksize = buffer->block_size;
-    size_t bytecount, malloc_len;
+    const size_t len = ARENA_ALIGN(_len ? _len : 1);
+    const size_t headerlen = ARENA_ALIGN(sizeof (ArenaChunk));
+    ArenaChunk *chunk = arena->chunks;
+    size_t bytecount;
+    void *retval;
 
-    if (len == 0) {
-        return NULL;
+    if ((chunk != NULL) && ((chunk->bytes - chunk->used) >= len)) {
+        retval = chunk->data + chunk->used;
+        chunk->used += len;
+        return retval;
     }
 
-    if (buffer->tail != NULL) {
-        const size_t tailbytes = buffer->tail->bytes;
-        const size_t avail = (tailbytes >= blocksize) ? 0 : blocksize - tailbytes;
-        if (len <= avail)
-        {
-            buffer->tail->bytes += len;
-            buffer->total_bytes += len;
-            SDL_assert(buffer->tail->bytes <= blocksize);
-            return (char *) buffer->tail->data + tailbytes;
+    /* Oversized requests get their own chunk. We put it behind the head, so
+       we can keep filling the current chunk with smaller allocations. */
+    bytecount = (len > arena->chunk_size) ? len : arena->chunk_size;
+    if ((bytecount == arena->chunk_size) && (arena->spare != NULL)) {
+        chunk = arena->spare;
+        arena->spare = chunk->next;
+    } else {
+        chunk = (ArenaChunk *) arena->m(headerlen + bytecount, arena->d);
+        if (chunk == NULL) {
+            return NULL;
         }
+        chunk->data = ((Uint8 *) chunk) + headerlen;
+        chunk->bytes = bytecount;
     }
 
-    /* need to allocate a new block (even if a previous block wasn't filled, so this buffer is contiguous). */
-    bytecount = len > blocksize ? len : blocksize;
-    malloc_len = sizeof (BufferBlock) + bytecount;
-    BufferBlock *item = (BufferBlock *) buffer->m(malloc_len, buffer->d);
-    if (item == NULL) {
-        return NULL;
-    }
-
-    item->data = ((Uint8 *) item) + sizeof (BufferBlock);
-    item->bytes = len;
-    item->next = NULL;
-    if (buffer->tail != NULL) {
-        buffer->tail->next = item;
+    chunk->used = len;
+    if ((len > arena->chunk_size) && (arena->chunks != NULL)) {
+        chunk->next = arena->chunks->next;
+        arena->chunks->next = chunk;
     } else {
-        buffer->head = item;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
     }
-    buffer->tail = item;
-
-    buffer->total_bytes += len;
 
-    return (char *) item->data;
+    return chunk->data;
 }
 
-SDL_bool buffer_append(Buffer *buffer, const void *_data, size_t len)
+void arena_reset(MemArena *arena)
 {
-    const Uint8 *data = (const Uint8 *) _data;
-
-    /* note that we make the blocks bigger than blocksize when we have enough
-       data to overfill a fresh block, to reduce allocations. */
-    const size_t blocksize = buffer->block_size;
+    ArenaChunk *chunk;
 
-    if (len == 0) {
-        return SDL_TRUE;
+    if (arena == NULL) {
+        return;  /* might happen if a reusable context ran out of memory creating it. */
     }
 
-    if (buffer->tail != NULL) {
-        const size_t tailbytes = buffer->tail->bytes;
-        const size_t avail = (tailbytes >= blocksize) ? 0 : blocksize - tailbytes;
-        const size_t cpy = (avail > len) ? len : avail;
-        if (cpy > 0) {
-            SDL_memcpy(buffer->tail->data + tailbytes, data, cpy);
-            len -= cpy;
-            data += cpy;
-            buffer->tail->bytes += cpy;
-            buffer->total_bytes += cpy;
-            SDL_assert(buffer->tail->bytes <= blocksize);
+    chunk = arena->chunks;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        if (chunk->bytes == arena->chunk_size) {
+            chunk->next = arena->spare;  /* keep it for the next round. */
+            arena->spare = chunk;
+        } else {
+            arena->f(chunk, arena->d);  /* oversized, let it go. */
         }
+        chunk = next;
     }
+    arena->chunks = NULL;
+}
 
-    if (len > 0) {
-        const size_t bytecount = len > blocksize ? len : blocksize;
-        const size_t malloc_len = sizeof (BufferBlock) + bytecount;
-        BufferBlock *item = (BufferBlock *) buffer->m(malloc_len, buffer->d);
-        SDL_assert((!buffer->tail) || (buffer->tail->bytes >= blocksize));
-        if (item == NULL) {
-            return SDL_FALSE;
+void arena_destroy(MemArena *arena)
+{
+    if (arena != NULL) {
+        SDL_SHADER_Free f = arena->f;
+        void *d = arena->d;
+        ArenaChunk *chunk;
+        arena_reset(arena);
+        chunk = arena->spare;
+        while (chunk != NULL) {
+            ArenaChunk *next = chunk->next;
+            f(chunk, d);
+            chunk = next;
+        }
+        f(arena, d);
+    }
+}
+
+
+/* Memory pools hand out fixed-size objects. Objects are carved out of
+   cache-line-aligned pages, and freed objects go on a free list to be
+   reused by the next allocation. Pages are only released when the pool
+   is destroyed. */
+
+#define POOL_CACHELINE_SIZE 64
+#define POOL_PAGE_SIZE 4096
+
+typedef struct PoolPage
+{
+    struct PoolPage *next;
+} PoolPage;
+
+typedef struct PoolFreeItem
+{
+    struct PoolFreeItem *next;
+} PoolFreeItem;
+
+struct MemPool
+{
+    size_t object_size;
+    size_t objects_per_page;
+    PoolFreeItem *freelist;
+    PoolPage *pages;
+    Uint8 *unused;  /* objects in the newest page that have never been handed out. */
+    size_t unused_count;
+    SDL_SHADER_Malloc m;
+    SDL_SHADER_Free f;
+    void *d;
+};
+
+MemPool *pool_create(const size_t objsize, SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
+{
+    MemPool *pool = (MemPool *) m(sizeof (MemPool), d);
+    if (pool != NULL) {
+        const size_t object_size = ARENA_ALIGN((objsize < sizeof (PoolFreeItem)) ? sizeof (PoolFreeItem) : objsize);
+        SDL_zerop(pool);
+        pool->object_size = object_size;
+        pool->objects_per_page = (object_size < POOL_PAGE_SIZE) ? (POOL_PAGE_SIZE / object_size) : 1;
+        pool->m = m;
+        pool->f = f;
+        pool->d = d;
+    }
+    return pool;
+}
+
+void *pool_alloc(MemPool *pool)
+{
+    void *retval;
+
+    if (pool->freelist != NULL) {
+        PoolFreeItem *item = pool->freelist;
+        pool->freelist = item->next;
+        return item;
+    }
+
+    if (pool->unused_count == 0) {
+        const size_t headerlen = sizeof (PoolPage) + (POOL_CACHELINE_SIZE - 1);
+        PoolPage *page = (PoolPage *) pool->m(headerlen + (pool->object_size * pool->objects_per_page), pool->d);
+        if (page == NULL) {
+            return NULL;
+        }
+        page->next = pool->pages;
+        pool->pages = page;
+        pool->unused = (Uint8 *) ((((size_t) (page + 1)) + (POOL_CACHELINE_SIZE - 1)) & ~((size_t) (POOL_CACHELINE_SIZE - 1)));
+        pool->unused_count = pool->objects_per_page;
+    }
+
+    retval = pool->unused;
+    pool->unused += pool->object_size;
+    pool->unused_count--;
+    return retval;
+}
+
+void pool_free(MemPool *pool, void *obj)
+{
+    if (obj != NULL) {
+        PoolFreeItem *item = (PoolFreeItem *) obj;
+        item->next = pool->freelist;
+        pool->freelist = item;
+    }
+}
+
+void pool_destroy(MemPool *pool)
+{
+    if (pool != NULL) {
+        SDL_SHADER_Free f = pool->f;
+        void *d = pool->d;
+        PoolPage *page = pool->pages;
+        while (page != NULL) {
+            PoolPage *next = page->next;
+            f(page, d);
+            page = next;
+        }
+        f(pool, d);
+    }
+}
+
+
+/* Blocks grow geometrically from the buffer's initial block size up to this,
+   so big outputs don't end up as thousands of tiny blocks. */
+#define BUFFER_MAX_BLOCK_SHIFT 14
+#define BUFFER_MAX_BLOCK_SIZE (((size_t) 1) << BUFFER_MAX_BLOCK_SHIFT)
+
+/* BufferPools recycle blocks by power-of-two size class, from 64 bytes up to
+   BUFFER_MAX_BLOCK_SIZE, and hold on to at most this much memory. */
+#define BUFFERPOOL_MIN_BLOCK_SHIFT 6
+#define BUFFERPOOL_NUM_CLASSES (BUFFER_MAX_BLOCK_SHIFT - BUFFERPOOL_MIN_BLOCK_SHIFT + 1)
+#define BUFFERPOOL_MAX_CACHED_BYTES (128 * 1024)
+
+typedef struct BufferBlock
+{
+    Uint8 *data;
+    size_t bytes;
+    size_t capacity;
+    struct BufferBlock *next;
+} BufferBlock;
+
+struct BufferPool
+{
+    BufferBlock *free_blocks[BUFFERPOOL_NUM_CLASSES];
+    size_t cached_bytes;
+    MemPool *buffers;  /* the Buffer structs themselves get recycled, too. */
+    SDL_SHADER_Malloc m;
+    SDL_SHADER_Free f;
+    void *d;
+};
+
+struct Buffer
+{
+    size_t total_bytes;
+    BufferBlock *head;
+    BufferBlock *tail;
+    size_t block_size;
+    size_t next_block_size;
+    BufferPool *bufpool;  /* NULL if this buffer doesn't recycle its blocks. */
+    SDL_SHADER_Malloc m;
+    SDL_SHADER_Free f;
+    void *d;
+};
+
+BufferPool *bufferpool_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
+{
+    BufferPool *bufpool = (BufferPool *) m(sizeof (BufferPool), d);
+    if (bufpool != NULL) {
+        SDL_zerop(bufpool);
+        bufpool->buffers = pool_create(sizeof (Buffer), m, f, d);
+        if (bufpool->buffers == NULL) {
+            f(bufpool, d);
+            return NULL;
+        }
+        bufpool->m = m;
+        bufpool->f = f;
+        bufpool->d = d;
+    }
+    return bufpool;
+}
+
+void bufferpool_destroy(BufferPool *bufpool)
+{
+    if (bufpool != NULL) {
+        SDL_SHADER_Free f = bufpool->f;
+        void *d = bufpool->d;
+        int i;
+        for (i = 0; i < BUFFERPOOL_NUM_CLASSES; i++) {
+            BufferBlock *item = bufpool->free_blocks[i];
+            while (item != NULL) {
+                BufferBlock *next = item->next;
+                f(item, d);
+                item = next;
+            }
+        }
+        pool_destroy(bufpool->buffers);
+        f(bufpool, d);
+    }
+}
+
+/* returns the size class for a block of `capacity` bytes, or -1 if a BufferPool can't recycle it. */
+static int bufferpool_class(const size_t capacity)
+{
+    int shift;
+    for (shift = BUFFERPOOL_MIN_BLOCK_SHIFT; shift <= BUFFER_MAX_BLOCK_SHIFT; shift++) {
+        if (capacity == (((size_t) 1) << shift)) {
+            return shift - BUFFERPOOL_MIN_BLOCK_SHIFT;
+        }
+    }
+    return -1;
+}
+
+static void buffer_init(Buffer *buffer, size_t blksz, BufferPool *bufpool, SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
+{
+    SDL_zerop(buffer);
+    buffer->block_size = blksz ? blksz : 1;
+    buffer->next_block_size = buffer->block_size;
+    buffer->bufpool = bufpool;
+    buffer->m = m;
+    buffer->f = f;
+    buffer->d = d;
+}
+
+Buffer *buffer_create(size_t blksz, SDL_SHADER_Malloc m,
+                      SDL_SHADER_Free f, void *d)
+{
+    Buffer *buffer = (Buffer *) m(sizeof (Buffer), d);
+    if (buffer != NULL) {
+        buffer_init(buffer, blksz, NULL, m, f, d);
+    }
+    return buffer;
+}
+
+Buffer *buffer_create_pooled(size_t blksz, BufferPool *bufpool)
+{
+    Buffer *buffer = (Buffer *) pool_alloc(bufpool->buffers);
+    if (buffer != NULL) {
+        buffer_init(buffer, blksz, bufpool, bufpool->m, bufpool->f, bufpool->d);
+    }
+    return buffer;
+}
+
+/* makes a new, empty block big enough for at least `len` bytes and links it in at the tail. */
+static BufferBlock *buffer_add_block(Buffer *buffer, const size_t len)
+{
+    BufferPool *bufpool = buffer->bufpool;
+    size_t capacity = buffer->next_block_size;
+    BufferBlock *item = NULL;
+
+    /* note that we make the blocks bigger than the usual size when we have
+       enough data to overfill a fresh block, to reduce allocations. */
+    if (capacity < len) {
+        capacity = len;
+    }
+
+    if (bufpool != NULL) {
+        /* round up to a size class so this block can be reused later. */
+        size_t cap = ((size_t) 1) << BUFFERPOOL_MIN_BLOCK_SHIFT;
+        while ((cap < capacity) && (cap < BUFFER_MAX_BLOCK_SIZE)) {
+            cap <<= 1;
+        }
+
+        if (cap >= capacity) {
+            const int blkclass = bufferpool_class(cap);
+            SDL_assert(blkclass >= 0);
+            capacity = cap;
+            item = bufpool->free_blocks[blkclass];
+            if (item != NULL) {
+                bufpool->free_blocks[blkclass] = item->next;
+                bufpool->cached_bytes -= capacity;
+            }
+        }
+    }
+
+    if (item == NULL) {
+        item = (BufferBlock *) buffer->m(sizeof (BufferBlock) + capacity, buffer->d);
+        if (item == NULL) {
+            return NULL;
         }
         item->data = ((Uint8 *) item) + sizeof (BufferBlock);
-        item->bytes = len;
-        item->next = NULL;
-        if (buffer->tail != NULL) {
-            buffer->tail->next = item;
-        } else {
-            buffer->head = item;
+        item->capacity = capacity;
+    }
+
+    SDL_assert(item->capacity == capacity);
+    item->bytes = 0;
+    item->next = NULL;
+    if (buffer->tail != NULL) {
+        buffer->tail->next = item;
+    } else {
+        buffer->head = item;
+    }
+    buffer->tail = item;
+
+    if (buffer->next_block_size < BUFFER_MAX_BLOCK_SIZE) {
+        buffer->next_block_size *= 2;
+        if (buffer->next_block_size > BUFFER_MAX_BLOCK_SIZE) {
+            buffer->next_block_size = BUFFER_MAX_BLOCK_SIZE;
+        }
+    }
+
+    return item;
+}
+
+static void buffer_free_block(Buffer *buffer, BufferBlock *item)
+{
+    BufferPool *bufpool = buffer->bufpool;
+    if (bufpool != NULL) {
+        const int blkclass = bufferpool_class(item->capacity);
+        if ((blkclass >= 0) && ((bufpool->cached_bytes + item->capacity) <= BUFFERPOOL_MAX_CACHED_BYTES)) {
+            item->next = bufpool->free_blocks[blkclass];
+            bufpool->free_blocks[blkclass] = item;
+            bufpool->cached_bytes += item->capacity;
+            return;
+        }
+    }
+    buffer->f(item, buffer->d);
+}
+
+char *buffer_reserve(Buffer *buffer, const size_t len)
+{
+    BufferBlock *item;
+
+    if (len == 0) {
+        return NULL;
+    }
+
+    if (buffer->tail != NULL) {
+        const size_t tailbytes = buffer->tail->bytes;
+        const size_t avail = buffer->tail->capacity - tailbytes;
+        if (len <= avail)
+        {
+            buffer->tail->bytes += len;
+            buffer->total_bytes += len;
+            return (char *) buffer->tail->data + tailbytes;
+        }
+    }
+
+    /* need to allocate a new block (even if a previous block wasn't filled, so this buffer is contiguous). */
+    item = buffer_add_block(buffer, len);
+    if (item == NULL) {
+        return NULL;
+    }
+
+    item->bytes = len;
+    buffer->total_bytes += len;
+
+    return (char *) item->data;
+}
+
+SDL_bool buffer_append(Buffer *buffer, const void *_data, size_t len)
+{
+    const Uint8 *data = (const Uint8 *) _data;
+
+    if (len == 0) {
+        return SDL_TRUE;
+    }
+
+    if (buffer->tail != NULL) {
+        const size_t tailbytes = buffer->tail->bytes;
+        const size_t avail = buffer->tail->capacity - tailbytes;
+        const size_t cpy = (avail > len) ? len : avail;
+        if (cpy > 0) {
+            SDL_memcpy(buffer->tail->data + tailbytes, data, cpy);
+            len -= cpy;
+            data += cpy;
+            buffer->tail->bytes += cpy;
+            buffer->total_bytes += cpy;
         }
-        buffer->tail = item;
+    }
 
+    if (len > 0) {
+        BufferBlock *item;
+        SDL_assert((!buffer->tail) || (buffer->tail->bytes == buffer->tail->capacity));
+        item = buffer_add_block(buffer, len);
+        if (item == NULL) {
+            return SDL_FALSE;
+        }
         SDL_memcpy(item->data, data, len);
+        item->bytes = len;
         buffer->total_bytes += len;
     }
 
@@ -818,37 +1601,66 @@ void buffer_empty(Buffer *buffer)
     BufferBlock *item = buffer->head;
     while (item != NULL) {
         BufferBlock *next = item->next;
-        buffer->f(item, buffer->d);
+        buffer_free_block(buffer, item);
         item = next;
     }
     buffer->head = buffer->tail = NULL;
     buffer->total_bytes = 0;
+    buffer->next_block_size = buffer->block_size;
 }
 
-char *buffer_flatten(Buffer *buffer)
+void buffer_flatten_into(Buffer *buffer, char *dst)
 {
-    char *retval = (char *) buffer->m(buffer->total_bytes + 1, buffer->d);
-    if (retval != NULL) {
-        BufferBlock *item = buffer->head;
-        char *ptr = retval;
-        while (item != NULL) {
-            BufferBlock *next = item->next;
-            SDL_memcpy(ptr, item->data, item->bytes);
-            ptr += item->bytes;
-            buffer->f(item, buffer->d);
-            item = next;
-        }
-        *ptr = '\0';
+    BufferBlock *item = buffer->head;
+    char *ptr = dst;
+    while (item != NULL) {
+        BufferBlock *next = item->next;
+        SDL_memcpy(ptr, item->data, item->bytes);
+        ptr += item->bytes;
+        buffer_free_block(buffer, item);
+        item = next;
+    }
+    *ptr = '\0';
 
-        SDL_assert(ptr == (retval + buffer->total_bytes));
+    SDL_assert(ptr == (dst + buffer->total_bytes));
 
-        buffer->head = buffer->tail = NULL;
-        buffer->total_bytes = 0;
+    buffer->head = buffer->tail = NULL;
+    buffer->total_bytes = 0;
+    buffer->next_block_size = buffer->block_size;
+}
+
+size_t buffer_iovec(Buffer *buffer, SDL_SHADER_OutputChunk *iov, const size_t iovcount)
+{
+    const BufferBlock *item;
+    size_t retval = 0;
+    for (item = buffer->head; item != NULL; item = item->next, retval++) {
+        if (retval < iovcount) {
+            iov[retval].data = item->data;
+            iov[retval].len = item->bytes;
+        }
     }
+    return retval;
+}
 
+char *buffer_flatten_padded(Buffer *buffer, const size_t padding)
+{
+    const size_t len = buffer->total_bytes;
+    char *retval;
+
+    SDL_assert(padding > 0);
+    retval = (char *) buffer->m(len + padding, buffer->d);
+    if (retval != NULL) {
+        buffer_flatten_into(buffer, retval);
+        SDL_memset(retval + len, '\0', padding);
+    }
     return retval;
 }
 
+char *buffer_flatten(Buffer *buffer)
+{
+    return buffer_flatten_padded(buffer, 1);
+}
+
 char *buffer_merge(Buffer **buffers, const size_t n, size_t *_len)
 {
     Buffer *first = NULL;
@@ -883,12 +1695,13 @@ char *buffer_merge(Buffer **buffers, const size_t n, size_t *_len)
                 BufferBlock *next = item->next;
                 SDL_memcpy(ptr, item->data, item->bytes);
                 ptr += item->bytes;
-                buffer->f(item, buffer->d);
+                buffer_free_block(buffer, item);
                 item = next;
             }
 
             buffer->head = buffer->tail = NULL;
             buffer->total_bytes = 0;
+            buffer->next_block_size = buffer->block_size;
         }
     }
 
@@ -905,7 +1718,11 @@ void buffer_destroy(Buffer *buffer)
         SDL_SHADER_Free f = buffer->f;
         void *d = buffer->d;
         buffer_empty(buffer);
-        f(buffer, d);
+        if (buffer->bufpool != NULL) {
+            pool_free(buffer->bufpool->buffers, buffer);
+        } else {
+            f(buffer, d);
+        }
     }
 }
 
@@ -1014,19 +1831,115 @@ ssize_t buffer_find(Buffer *buffer, const size_t start, const void *_data, const
     return -1;  /* no match found. */
 }
 
+/* Malloc() puts one of these in front of every allocation, so Free() knows
+   how big it was and which phase to credit it back to. */
+typedef union MallocHeader
+{
+    struct
+    {
+        size_t len;
+        SDL_SHADER_MemoryPhase phase;
+    } info;
+    ArenaAlignment align;  /* keep the app's pointer aligned. */
+} MallocHeader;
+
+static void memusage_add(SDL_SHADER_MemoryUsage *usage, const size_t len)
+{
+    usage->current_bytes += len;
+    usage->allocations++;
+    if (usage->current_bytes > usage->peak_bytes) {
+        usage->peak_bytes = usage->current_bytes;
+    }
+}
+
+static void memstats_remove(Context *ctx, const MallocHeader *hdr)
+{
+    SDL_assert(ctx->memstats.phases[hdr->info.phase].current_bytes >= hdr->info.len);
+    ctx->memstats.phases[hdr->info.phase].current_bytes -= hdr->info.len;
+    ctx->memstats.total.current_bytes -= hdr->info.len;
+}
+
 void *Malloc(Context *ctx, const size_t len)
 {
-    void *retval = ctx->malloc((int) len, ctx->malloc_data);
-    if (retval == NULL) {
+    const size_t total = len + sizeof (MallocHeader);
+    MallocHeader *hdr = (MallocHeader *) ctx->malloc((int) total, ctx->malloc_data);
+    if (hdr == NULL) {
         ctx->isfail = SDL_TRUE;
         ctx->out_of_memory = SDL_TRUE;
+        return NULL;
     }
-    return retval;
+
+    hdr->info.len = total;
+    hdr->info.phase = ctx->memphase;
+    memusage_add(&ctx->memstats.phases[ctx->memphase], total);
+    memusage_add(&ctx->memstats.total, total);
+    return hdr + 1;
+}
+
+void *Realloc(Context *ctx, void *ptr, const size_t len)
+{
+    MallocHeader *hdr;
+    size_t total;
+
+    if (ptr == NULL) {
+        return Malloc(ctx, len);
+    }
+
+    hdr = ((MallocHeader *) ptr) - 1;
+
+    /* no hook? Do it the old-fashioned way. */
+    if (ctx->realloc == NULL) {
+        const size_t oldlen = hdr->info.len - sizeof (MallocHeader);
+        void *retval = Malloc(ctx, len);
+        if (retval != NULL) {
+            SDL_memcpy(retval, ptr, (oldlen < len) ? oldlen : len);
+            Free(ctx, ptr);
+        }
+        return retval;
+    }
+
+    total = len + sizeof (MallocHeader);
+    hdr = (MallocHeader *) ctx->realloc(hdr, hdr->info.len, total, ctx->malloc_data);
+    if (hdr == NULL) {
+        ctx->isfail = SDL_TRUE;
+        ctx->out_of_memory = SDL_TRUE;
+        return NULL;
+    }
+
+    /* the header moved with the data, so this still knows the old size and phase. */
+    memstats_remove(ctx, hdr);
+    hdr->info.len = total;
+    hdr->info.phase = ctx->memphase;
+    memusage_add(&ctx->memstats.phases[ctx->memphase], total);
+    memusage_add(&ctx->memstats.total, total);
+    return hdr + 1;
 }
 
 void Free(Context *ctx, void *ptr)
 {
-    ctx->free(ptr, ctx->malloc_data);
+    if (ptr != NULL) {
+        MallocHeader *hdr = ((MallocHeader *) ptr) - 1;
+        memstats_remove(ctx, hdr);
+        if (ctx->sized_free) {
+            ctx->sized_free(hdr, hdr->info.len, ctx->malloc_data);
+        } else {
+            ctx->free(hdr, ctx->malloc_data);
+        }
+    }
+}
+
+void Disown(Context *ctx, const void *ptr)
+{
+    if (ptr != NULL) {
+        memstats_remove(ctx, ((const MallocHeader *) ptr) - 1);
+    }
+}
+
+void FreeReturnedData(SDL_SHADER_Free f, void *d, const void *ptr)
+{
+    if (ptr != NULL) {
+        f((void *) (((const MallocHeader *) ptr) - 1), d);
+    }
 }
 
 void *MallocContextBridge(size_t bytes, void *data)
@@ -1034,6 +1947,12 @@ void *MallocContextBridge(size_t bytes, void *data)
     return Malloc((Context *) data, bytes);
 }
 
+void *ReallocContextBridge(void *ptr, size_t oldbytes, size_t newbytes, void *data)
+{
+    (void) oldbytes;  /* Realloc() already knows this. */
+    return Realloc((Context *) data, ptr, newbytes);
+}
+
 void FreeContextBridge(void *ptr, void *data)
 {
     Free((Context *) data, ptr);
@@ -1049,16 +1968,601 @@ char *StrDup(Context *ctx, const char *str)
     return retval;
 }
 
+size_t source_position_add_file(Context *ctx, const char *source, const size_t srclen)
+{
+    LineIndex *index;
+
+    if (srclen > 0xFFFFFFFF) {
+        return 0;  /* we just won't have columns for this one. */
+    }
+
+    index = (LineIndex *) Malloc(ctx, sizeof (LineIndex));
+    if (index == NULL) {
+        return 0;
+    }
+
+    if (ctx->next_source_position == 0) {
+        ctx->next_source_position = 1;  /* 0 means "nowhere". */
+    }
+
+    index->base = ctx->next_source_position;
+    index->length = srclen;
+    index->source = source;
+    index->count = 0;
+    index->starts = NULL;
+    index->next = ctx->line_indexes;
+    ctx->line_indexes = index;
+    ctx->next_source_position += srclen + 1;  /* +1 so a token at the very end still belongs to this file. */
+
+    return index->base;
+}
+
+static SDL_bool add_line_start(Context *ctx, LineIndex *index, Uint32 *capacity, const Uint32 offset)
+{
+    if (index->count == *capacity) {
+        const Uint32 newcapacity = *capacity * 2;
+        Uint32 *ptr = (Uint32 *) Realloc(ctx, index->starts, newcapacity * sizeof (Uint32));
+        if (ptr == NULL) {
+            return SDL_FALSE;
+        }
+        index->starts = ptr;
+        *capacity = newcapacity;
+    }
+    index->starts[index->count++] = offset;
+    return SDL_TRUE;
+}
+
+/* finds the offset of each line start in index->source. On failure, the file just won't have columns. */
+static void build_line_index(Context *ctx, LineIndex *index)
+{
+    const char *source = index->source;
+    const char *end = source + index->length;
+    const char *ptr = source;
+    Uint32 capacity = 256;
+
+    index->source = NULL;  /* only try this once. */
+    index->starts = (Uint32 *) Malloc(ctx, capacity * sizeof (Uint32));
+    if (index->starts == NULL) {
+        return;
+    }
+    index->starts[0] = 0;
+    index->count = 1;
+
+    /* a line starts after every "\n", and every "\r" that isn't half of a "\r\n".
+       Nearly everything uses "\n" alone, so let memchr() find those quickly. */
+    if (memchr(source, '\r', index->length) == NULL) {
+        while ((ptr = (const char *) memchr(ptr, '\n', (size_t) (end - ptr))) != NULL) {
+            ptr++;
+            if (!add_line_start(ctx, index, &capacity, (Uint32) (ptr - source))) {
+                break;
+            }
+        }
+    } else {
+        for (; ptr < end; ptr++) {
+            const char ch = *ptr;
+            if ((ch == '\n') || ((ch == '\r') && (ptr[1] != '\n'))) {  /* ptr[1] is safe, source is padded. */
+                if (!add_line_start(ctx, index, &capacity, (Uint32) ((ptr + 1) - source))) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (ctx->out_of_memory) {
+        Free(ctx, index->starts);
+        index->starts = NULL;
+        index->count = 0;
+    }
+}
+
+void source_position_close_file(Context *ctx, const size_t base)
+{
+    LineIndex *index;
+    for (index = ctx->line_indexes; index != NULL; index = index->next) {
+        if (index->base == base) {
+            /* AST nodes can still ask for columns after the source is gone, so index it while we can. */
+            if (index->source && ctx->uses_ast) {
+                build_line_index(ctx, index);
+            }
+            index->source = NULL;
+            return;
+        }
+    }
+}
+
+/* finds the line `position` is on, returning its index (from 0) and its LineIndex. */
+static const LineIndex *find_source_line(Context *ctx, const size_t position, Uint32 *_line)
+{
+    LineIndex *index;
+
+    if (position == 0) {
+        return NULL;
+    }
+
+    for (index = ctx->line_indexes; index != NULL; index = index->next) {
+        if ((position >= index->base) && (position <= (index->base + index->length))) {
+            const Uint32 offset = (Uint32) (position - index->base);
+            Uint32 lo = 0;
+            Uint32 hi;
+
+            if (index->source != NULL) {
+                build_line_index(ctx, index);
+            }
+
+            if (index->starts == NULL) {
+                return NULL;
+            }
+
+            hi = index->count - 1;
+            while (lo < hi) {  /* find the last line that starts at or before offset. */
+                const Uint32 mid = lo + ((hi - lo + 1) / 2);
+                if (index->starts[mid] <= offset) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            *_line = lo;
+            return index;
+        }
+    }
+
+    return NULL;
+}
+
+Sint32 source_position_line(Context *ctx, const size_t position)
+{
+    Uint32 line = 0;
+    return find_source_line(ctx, position, &line) ? ((Sint32) line) + 1 : 0;
+}
+
+Sint32 source_position_column(Context *ctx, const size_t position)
+{
+    Uint32 line = 0;
+    const LineIndex *index = find_source_line(ctx, position, &line);
+    return index ? ((Sint32) ((position - index->base) - index->starts[line])) + 1 : 0;
+}
+
+/* SIMD byte scans. SDL_cpuinfo.h already pulls in the intrinsics headers this
+   compiler has, so we only build the kernels it can use, and pick between
+   them at runtime with SDL_HasAVX2() and friends. */
+#if (defined(__SSE2__) && !defined(SDL_DISABLE_EMMINTRIN_H)) || (defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))))
+#define SCAN_HAVE_SSE2 1
+#endif
+
+#if defined(SCAN_HAVE_SSE2) && ((defined(HAVE_IMMINTRIN_H) && !defined(SDL_DISABLE_IMMINTRIN_H)) || (defined(_MSC_VER) && (_MSC_VER >= 1800)))
+#define SCAN_HAVE_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#else
+#define SCAN_TARGET_AVX2
+#endif
+#endif
+
+#if defined(__ARM_NEON) && !defined(SDL_DISABLE_ARM_NEON_H)
+#define SCAN_HAVE_NEON 1
+#endif
+
+typedef enum ScanKernel
+{
+    SCAN_KERNEL_UNKNOWN,
+    SCAN_KERNEL_SCALAR,
+    SCAN_KERNEL_SSE2,
+    SCAN_KERNEL_AVX2,
+    SCAN_KERNEL_NEON
+} ScanKernel;
+
+static ScanKernel scan_kernel = SCAN_KERNEL_UNKNOWN;  /* every thread figures out the same thing, so racing on this is harmless. */
+
+static ScanKernel get_scan_kernel(void)
+{
+    if (scan_kernel == SCAN_KERNEL_UNKNOWN) {
+        ScanKernel kernel = SCAN_KERNEL_SCALAR;
+        #if defined(SCAN_HAVE_AVX2)
+        if (SDL_HasAVX2()) {
+            kernel = SCAN_KERNEL_AVX2;
+        } else
+        #endif
+        #if defined(SCAN_HAVE_SSE2)
+        if (SDL_HasSSE2()) {
+            kernel = SCAN_KERNEL_SSE2;
+        }
+        #endif
+        #if defined(SCAN_HAVE_NEON)
+        if (SDL_HasNEON()) {
+            kernel = SCAN_KERNEL_NEON;
+        }
+        #endif
+        scan_kernel = kernel;
+    }
+    return scan_kernel;
+}
+
+/* index of the lowest set bit; x must not be zero. */
+static inline int lowest_bit(Uint64 x)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+    #elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long retval;
+    _BitScanForward64(&retval, x);
+    return (int) retval;
+    #else
+    int retval = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        retval++;
+    }
+    return retval;
+    #endif
+}
+
+/* Without a POPCNT instruction to count with, GCC calls into libgcc, which
+   is slower than just doing it here. */
+static inline int count_bits(Uint64 x)
+{
+    #if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || defined(__aarch64__))
+    return __builtin_popcountll(x);
+    #else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int) ((x * 0x0101010101010101ULL) >> 56);
+    #endif
+}
+
+/* the portable version, and what the SIMD kernels finish up with. */
+static const char *scan_bytes_scalar(const char *str, const ByteScan *scan, Sint32 *newlines)
+{
+    const Uint8 *table = scan->table;
+    const Uint8 *ptr = (const Uint8 *) str;
+
+    while (SDL_TRUE) {
+        while (!table[ptr[0]] && !table[ptr[1]] && !table[ptr[2]] && !table[ptr[3]]) {
+            ptr += 4;
+        }
+        while (!table[*ptr]) {
+            ptr++;
+        }
+        if (table[*ptr] != BYTESCAN_NEWLINE) {
+            return (const char *) ptr;
+        }
+        (*newlines)++;
+        ptr++;
+    }
+}
+
+/* For the SIMD kernels: `hits` is a bitmask of the stop bytes in a chunk
+   (one bit per byte, or four on NEON), and `nl` is the same for '\n'. This
+   keeps just the newlines before the first stop, which are the ones the
+   scan moved past. */
+static inline Uint64 newlines_before(const Uint64 hits, const Uint64 nl)
+{
+    return hits ? (nl & ((((Uint64) 1) << lowest_bit(hits)) - 1)) : nl;
+}
+
+/* The kernels always check all eight of scan->bytes; the unused ones are
+   null, which every scan stops at anyway, so they don't change anything. */
+#if defined(SCAN_HAVE_SSE2)
+static inline __m128i sse2_any_equal(const __m128i chunk, const __m128i *stops)
+{
+    return _mm_or_si128(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, stops[0]), _mm_cmpeq_epi8(chunk, stops[1])),
+                     _mm_or_si128(_mm_cmpeq_epi8(chunk, stops[2]), _mm_cmpeq_epi8(chunk, stops[3]))),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, stops[4]), _mm_cmpeq_epi8(chunk, stops[5])),
+                     _mm_or_si128(_mm_cmpeq_epi8(chunk, stops[6]), _mm_cmpeq_epi8(chunk, stops[7]))));
+}
+
+static const char *scan_bytes_sse2(const char *ptr, const char *end, const ByteScan *scan, Sint32 *newlines)
+{
+    const Uint8 *bytes = scan->bytes;
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i stops[8] = {
+        _mm_set1_epi8((char) bytes[0]), _mm_set1_epi8((char) bytes[1]), _mm_set1_epi8((char) bytes[2]), _mm_set1_epi8((char) bytes[3]),
+        _mm_set1_epi8((char) bytes[4]), _mm_set1_epi8((char) bytes[5]), _mm_set1_epi8((char) bytes[6]), _mm_set1_epi8((char) bytes[7])
+    };
+
+    while ((end - ptr) >= 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *) ptr);
+        const Uint32 hits = (Uint32) _mm_movemask_epi8(sse2_any_equal(chunk, stops));
+        if (scan->count_newlines) {
+            const Uint64 nl = newlines_before(hits, (Uint32) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+            if (nl) {
+                *newlines += count_bits(nl);
+            }
+        }
+        if (hits) {
+            return ptr + lowest_bit(hits);
+        }
+        ptr += 16;
+    }
+
+    return scan_bytes_scalar(ptr, scan, newlines);
+}
+#endif
+
+#if defined(SCAN_HAVE_AVX2)
+/* every CPU with AVX2 has POPCNT, too. */
+static inline SCAN_TARGET_AVX2 int avx2_count_bits(const Uint64 x)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+    #elif defined(_M_X64)
+    return (int) __popcnt64(x);
+    #else
+    return (int) (__popcnt((Uint32) x) + __popcnt((Uint32) (x >> 32)));
+    #endif
+}
+
+static inline SCAN_TARGET_AVX2 __m256i avx2_any_equal(const __m256i chunk, const __m256i *stops)
+{
+    return _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, stops[0]), _mm256_cmpeq_epi8(chunk, stops[1])),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, stops[2]), _mm256_cmpeq_epi8(chunk, stops[3]))),
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, stops[4]), _mm256_cmpeq_epi8(chunk, stops[5])),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, stops[6]), _mm256_cmpeq_epi8(chunk, stops[7]))));
+}
+
+static SCAN_TARGET_AVX2 const char *scan_bytes_avx2(const char *ptr, const char *end, const ByteScan *scan, Sint32 *newlines)
+{
+    const Uint8 *bytes = scan->bytes;
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i stops[8] = {
+        _mm256_set1_epi8((char) bytes[0]), _mm256_set1_epi8((char) bytes[1]), _mm256_set1_epi8((char) bytes[2]), _mm256_set1_epi8((char) bytes[3]),
+        _mm256_set1_epi8((char) bytes[4]), _mm256_set1_epi8((char) bytes[5]), _mm256_set1_epi8((char) bytes[6]), _mm256_set1_epi8((char) bytes[7])
+    };
+
+    while ((end - ptr) >= 32) {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i *) ptr);
+        const Uint32 hits = (Uint32) _mm256_movemask_epi8(avx2_any_equal(chunk, stops));
+        if (scan->count_newlines) {
+            const Uint64 nl = newlines_before(hits, (Uint32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+            if (nl) {
+                *newlines += avx2_count_bits(nl);
+            }
+        }
+        if (hits) {
+            return ptr + lowest_bit(hits);
+        }
+        ptr += 32;
+    }
+
+    return scan_bytes_sse2(ptr, end, scan, newlines);  /* finish the last few bytes a little quicker. */
+}
+#endif
+
+#if defined(SCAN_HAVE_NEON)
+static inline uint8x16_t neon_any_equal(const uint8x16_t chunk, const uint8x16_t *stops)
+{
+    return vorrq_u8(
+        vorrq_u8(vorrq_u8(vceqq_u8(chunk, stops[0]), vceqq_u8(chunk, stops[1])),
+                 vorrq_u8(vceqq_u8(chunk, stops[2]), vceqq_u8(chunk, stops[3]))),
+        vorrq_u8(vorrq_u8(vceqq_u8(chunk, stops[4]), vceqq_u8(chunk, stops[5])),
+                 vorrq_u8(vceqq_u8(chunk, stops[6]), vceqq_u8(chunk, stops[7]))));
+}
+
+/* NEON has no movemask, so narrow each 0x00/0xFF byte down to four bits of a Uint64. */
+static inline Uint64 neon_bitmask(const uint8x16_t cmp)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0);
+}
+
+static const char *scan_bytes_neon(const char *ptr, const char *end, const ByteScan *scan, Sint32 *newlines)
+{
+    const Uint8 *bytes = scan->bytes;
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t stops[8] = {
+        vdupq_n_u8(bytes[0]), vdupq_n_u8(bytes[1]), vdupq_n_u8(bytes[2]), vdupq_n_u8(bytes[3]),
+        vdupq_n_u8(bytes[4]), vdupq_n_u8(bytes[5]), vdupq_n_u8(bytes[6]), vdupq_n_u8(bytes[7])
+    };
+
+    while ((end - ptr) >= 16) {
+        const uint8x16_t chunk = vld1q_u8((const Uint8 *) ptr);
+        const Uint64 hits = neon_bitmask(neon_any_equal(chunk, stops));
+        if (scan->count_newlines) {
+            /* four bits per newline, so only count one of them. */
+            const Uint64 nl = newlines_before(hits, neon_bitmask(vceqq_u8(chunk, newline)) & 0x1111111111111111ULL);
+            if (nl) {
+                *newlines += count_bits(nl);
+            }
+        }
+        if (hits) {
+            return ptr + (lowest_bit(hits) / 4);
+        }
+        ptr += 16;
+    }
+
+    return scan_bytes_scalar(ptr, scan, newlines);
+}
+#endif
+
+const char *scan_bytes_simd(const char *ptr, const char *end, const ByteScan *scan, Sint32 *newlines)
+{
+    SDL_assert(!scan->count_newlines || (newlines != NULL));
+
+    switch (get_scan_kernel()) {
+        #if defined(SCAN_HAVE_AVX2)
+        case SCAN_KERNEL_AVX2: return scan_bytes_avx2(ptr, end, scan, newlines);
+        #endif
+        #if defined(SCAN_HAVE_SSE2)
+        case SCAN_KERNEL_SSE2: return scan_bytes_sse2(ptr, end, scan, newlines);
+        #endif
+        #if defined(SCAN_HAVE_NEON)
+        case SCAN_KERNEL_NEON: return scan_bytes_neon(ptr, end, scan, newlines);
+        #endif
+        default: break;
+    }
+    return scan_bytes_scalar(ptr, scan, newlines);
+}
+
+/* Sources are nearly all ASCII, so utf8_find_invalid() skips over that in
+   bulk. These return how many bytes at the start of `str` are ASCII, up to
+   `len`. Unlike scan_bytes(), they don't need any padding. */
+static size_t ascii_span_scalar(const Uint8 *str, const size_t len)
+{
+    size_t i = 0;
+
+    for (; (len - i) >= 8; i += 8) {
+        Uint64 chunk;
+        SDL_memcpy(&chunk, str + i, sizeof (chunk));
+        if (chunk & 0x8080808080808080ULL) {
+            break;
+        }
+    }
+
+    while ((i < len) && (str[i] < 0x80)) {
+        i++;
+    }
+
+    return i;
+}
+
+#if defined(SCAN_HAVE_SSE2)
+static size_t ascii_span_sse2(const Uint8 *str, const size_t len)
+{
+    size_t i = 0;
+
+    for (; (len - i) >= 16; i += 16) {
+        const Uint32 hibits = (Uint32) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (str + i)));
+        if (hibits) {
+            return i + lowest_bit(hibits);
+        }
+    }
+
+    return i + ascii_span_scalar(str + i, len - i);
+}
+#endif
+
+#if defined(SCAN_HAVE_AVX2)
+static SCAN_TARGET_AVX2 size_t ascii_span_avx2(const Uint8 *str, const size_t len)
+{
+    size_t i = 0;
+
+    for (; (len - i) >= 32; i += 32) {
+        const Uint32 hibits = (Uint32) _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *) (str + i)));
+        if (hibits) {
+            return i + lowest_bit(hibits);
+        }
+    }
+
+    return i + ascii_span_sse2(str + i, len - i);
+}
+#endif
+
+#if defined(SCAN_HAVE_NEON)
+static size_t ascii_span_neon(const Uint8 *str, const size_t len)
+{
+    const uint8x16_t highbit = vdupq_n_u8(0x80);
+    size_t i = 0;
+
+    for (; (len - i) >= 16; i += 16) {
+        const Uint64 hibits = neon_bitmask(vtstq_u8(vld1q_u8(str + i), highbit));
+        if (hibits) {
+            return i + (lowest_bit(hibits) / 4);
+        }
+    }
+
+    return i + ascii_span_scalar(str + i, len - i);
+}
+#endif
+
+static size_t ascii_span(const Uint8 *str, const size_t len)
+{
+    switch (get_scan_kernel()) {
+        #if defined(SCAN_HAVE_AVX2)
+        case SCAN_KERNEL_AVX2: return ascii_span_avx2(str, len);
+        #endif
+        #if defined(SCAN_HAVE_SSE2)
+        case SCAN_KERNEL_SSE2: return ascii_span_sse2(str, len);
+        #endif
+        #if defined(SCAN_HAVE_NEON)
+        case SCAN_KERNEL_NEON: return ascii_span_neon(str, len);
+        #endif
+        default: break;
+    }
+    return ascii_span_scalar(str, len);
+}
+
+size_t utf8_find_invalid(const char *str, const size_t len)
+{
+    const Uint8 *start = (const Uint8 *) str;
+    const Uint8 *end = start + len;
+    const Uint8 *ptr = start;
+
+    while (ptr < end) {
+        Uint8 lo = 0x80;  /* the allowed range for the second byte; it's narrower for some lead bytes. */
+        Uint8 hi = 0xBF;
+        size_t seqlen;
+        size_t i;
+
+        ptr += ascii_span(ptr, (size_t) (end - ptr));
+        if (ptr == end) {
+            break;
+        }
+
+        /* this is Table 3-7 from the Unicode standard: no overlong forms,
+           no surrogates, nothing past U+10FFFF. */
+        switch (*ptr) {
+            case 0xC2: case 0xC3: case 0xC4: case 0xC5: case 0xC6: case 0xC7: case 0xC8: case 0xC9:
+            case 0xCA: case 0xCB: case 0xCC: case 0xCD: case 0xCE: case 0xCF: case 0xD0: case 0xD1:
+            case 0xD2: case 0xD3: case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8: case 0xD9:
+            case 0xDA: case 0xDB: case 0xDC: case 0xDD: case 0xDE: case 0xDF:
+                seqlen = 2;
+                break;
+            case 0xE0: seqlen = 3; lo = 0xA0; break;
+            case 0xED: seqlen = 3; hi = 0x9F; break;
+            case 0xE1: case 0xE2: case 0xE3: case 0xE4: case 0xE5: case 0xE6: case 0xE7: case 0xE8:
+            case 0xE9: case 0xEA: case 0xEB: case 0xEC: case 0xEE: case 0xEF:
+                seqlen = 3;
+                break;
+            case 0xF0: seqlen = 4; lo = 0x90; break;
+            case 0xF1: case 0xF2: case 0xF3: seqlen = 4; break;
+            case 0xF4: seqlen = 4; hi = 0x8F; break;
+            default: return (size_t) (ptr - start);  /* stray continuation byte, or a lead byte that's never legal. */
+        }
+
+        if (((size_t) (end - ptr)) < seqlen) {
+            return (size_t) (ptr - start);  /* truncated at the end of the source. */
+        } else if ((ptr[1] < lo) || (ptr[1] > hi)) {
+            return (size_t) (ptr - start);
+        }
+
+        for (i = 2; i < seqlen; i++) {
+            if ((ptr[i] & 0xC0) != 0x80) {
+                return (size_t) (ptr - start);
+            }
+        }
+
+        ptr += seqlen;
+    }
+
+    return len;
+}
+
+void source_position_reset(Context *ctx)
+{
+    LineIndex *index = ctx->line_indexes;
+    while (index != NULL) {
+        LineIndex *next = index->next;
+        Free(ctx, index->starts);
+        Free(ctx, index);
+        index = next;
+    }
+    ctx->line_indexes = NULL;
+    ctx->next_source_position = 0;
+    ctx->source_position = 0;
+}
+
 void fail(Context *ctx, const char *reason)
 {
     ctx->isfail = SDL_TRUE;
-    errorlist_add(ctx->errors, SDL_TRUE, ctx->filename, ctx->position, reason);
+    errorlist_add(ctx->errors, SDL_TRUE, ctx->filename, ctx->position, source_position_column(ctx, ctx->source_position), reason);
 }
 
 void fail_ast(Context *ctx, const SDL_SHADER_AstNodeInfo *ast, const char *reason)
 {
     ctx->isfail = SDL_TRUE;
-    errorlist_add(ctx->errors, SDL_TRUE, ast->filename, ast->line, reason);
+    errorlist_add(ctx->errors, SDL_TRUE, ast->filename, ast->line, source_position_column(ctx, ast->position), reason);
 }
 
 void failf(Context *ctx, const char *fmt, ...)
@@ -1066,7 +2570,7 @@ void failf(Context *ctx, const char *fmt, ...)
     va_list ap;
     ctx->isfail = SDL_TRUE;
     va_start(ap, fmt);
-    errorlist_add_va(ctx->errors, SDL_TRUE, ctx->filename, ctx->position, fmt, ap);
+    errorlist_add_va(ctx->errors, SDL_TRUE, ctx->filename, ctx->position, source_position_column(ctx, ctx->source_position), fmt, ap);
     va_end(ap);
 }
 
@@ -1075,25 +2579,25 @@ void failf_ast(Context *ctx, const SDL_SHADER_AstNodeInfo *ast, const char *fmt,
     va_list ap;
     ctx->isfail = SDL_TRUE;
     va_start(ap, fmt);
-    errorlist_add_va(ctx->errors, SDL_TRUE, ast->filename, ast->line, fmt, ap);
+    errorlist_add_va(ctx->errors, SDL_TRUE, ast->filename, ast->line, source_position_column(ctx, ast->position), fmt, ap);
     va_end(ap);
 }
 
 void warn(Context *ctx, const char *reason)
 {
-    errorlist_add(ctx->errors, SDL_FALSE, ctx->filename, ctx->position, reason);
+    errorlist_add(ctx->errors, SDL_FALSE, ctx->filename, ctx->position, source_position_column(ctx, ctx->source_position), reason);
 }
 
 void warn_ast(Context *ctx, const SDL_SHADER_AstNodeInfo *ast, const char *reason)
 {
-    errorlist_add(ctx->errors, SDL_FALSE, ast->filename, ast->line, reason);
+    errorlist_add(ctx->errors, SDL_FALSE, ast->filename, ast->line, source_position_column(ctx, ast->position), reason);
 }
 
 void warnf(Context *ctx, const char *fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    errorlist_add_va(ctx->errors, SDL_FALSE, ctx->filename, ctx->position, fmt, ap);
+    errorlist_add_va(ctx->errors, SDL_FALSE, ctx->filename, ctx->position, source_position_column(ctx, ctx->source_position), fmt, ap);
     va_end(ap);
 }
 
@@ -1101,11 +2605,54 @@ void warnf_ast(Context *ctx, const SDL_SHADER_AstNodeInfo *ast, const char *fmt,
 {
     va_list ap;
     va_start(ap, fmt);
-    errorlist_add_va(ctx->errors, SDL_FALSE, ast->filename, ast->line, fmt, ap);
+    errorlist_add_va(ctx->errors, SDL_FALSE, ast->filename, ast->line, source_position_column(ctx, ast->position), fmt, ap);
     va_end(ap);
 }
 
 
+SDL_bool context_reset(Context *ctx)
+{
+    int i;
+
+    SDL_assert(ctx->reusable);
+    SDL_assert(!ctx->uses_preprocessor && !ctx->uses_ast && !ctx->uses_compiler);
+
+    /* if the last run ran out of memory, we can't trust anything it left
+       behind, so throw it all out and start fresh. */
+    if (ctx->out_of_memory) {
+        ctx->reusable = SDL_FALSE;
+        preprocessor_end(ctx);
+        ast_end(ctx);
+        compiler_end(ctx);
+        ctx->reusable = SDL_TRUE;
+    }
+
+    /* errors are normally flattened into the previous run's results, but not if that failed.
+       If we couldn't make a new list last time, try again now. */
+    if ((ctx->errors == NULL) || (errorlist_count(ctx->errors) > 0)) {
+        errorlist_destroy(ctx->errors);
+        ctx->errors = errorlist_create(MallocContextBridge, ReallocContextBridge, FreeContextBridge, ctx);
+    }
+
+    ctx->isfail = SDL_FALSE;
+    ctx->out_of_memory = SDL_FALSE;
+    ctx->filename = NULL;
+    ctx->position = 0;
+    source_position_reset(ctx);
+
+    /* memory we're still holding from previous runs stays in current_bytes,
+       but peaks and allocation counts are per-run. */
+    for (i = 0; i < SDL_SHADER_NUM_MEMPHASES; i++) {
+        ctx->memstats.phases[i].peak_bytes = ctx->memstats.phases[i].current_bytes;
+        ctx->memstats.phases[i].allocations = 0;
+    }
+    ctx->memstats.total.peak_bytes = ctx->memstats.total.current_bytes;
+    ctx->memstats.total.allocations = 0;
+    ctx->memphase = SDL_SHADER_MEMPHASE_PREPROCESS;
+
+    return (ctx->errors != NULL) ? SDL_TRUE : SDL_FALSE;
+}
+
 Context *context_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
 {
     Context *ctx;
@@ -1127,7 +2674,7 @@ Context *context_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
     ctx->free = f;
     ctx->malloc_data = d;
 
-    ctx->errors = errorlist_create(MallocContextBridge, FreeContextBridge, ctx);
+    ctx->errors = errorlist_create(MallocContextBridge, ReallocContextBridge, FreeContextBridge, ctx);
     if (!ctx->errors) { goto context_create_failed; }
 
     return ctx;
@@ -1137,18 +2684,37 @@ context_create_failed:
     return NULL;
 }
 
+Context *context_create_from_params(const SDL_SHADER_CompilerParams *params)
+{
+    Context *ctx = context_create(params->allocate, params->deallocate, params->allocate_data);
+    if (ctx != NULL) {
+        /* the hooks have to work on the app's heap, so they're no good with our default allocator. */
+        if ((params->allocate != NULL) && (params->deallocate != NULL)) {
+            ctx->realloc = params->reallocate;
+            ctx->sized_free = params->sized_deallocate;
+        }
+    }
+    return ctx;
+}
+
 void context_destroy(Context *ctx)
 {
     if (ctx) {
         SDL_SHADER_Free f = ctx->free;
+        SDL_SHADER_SizedFree sf = ctx->sized_free;
         void *d = ctx->malloc_data;
 
         errorlist_destroy(ctx->errors);
         preprocessor_end(ctx);
         ast_end(ctx);
         compiler_end(ctx);
+        source_position_reset(ctx);
 
-        f(ctx, d);
+        if (sf) {
+            sf(ctx, sizeof (Context), d);
+        } else {
+            f(ctx, d);
+        }
     }
 }
 
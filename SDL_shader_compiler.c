@@ -191,10 +191,152 @@ static void semantic_analysis_check_globals_for_duplicates(Context *ctx)
     }
 }
 
+static void datatypes_nuke(const void *key, const void *value, void *data);
+
+/* The intrinsic types (float4x4, etc) never change, so we build them once,
+   the first time any context needs them, and every context (on any thread)
+   shares them read-only after that. Since they outlive any context, they use
+   SDL's allocator and not the app's, and are never freed. */
+#define NUM_BUILTIN_SCALAR_DATATYPES 5
+#define NUM_BUILTIN_DATATYPES (NUM_BUILTIN_SCALAR_DATATYPES * (1 + 3 + (3 * 3)))  /* each scalar, plus 3 vectors and 9 matrices of it. */
+
+typedef struct BuiltinDataTypes
+{
+    StringCache *strcache;
+    HashTable *table;
+    const DataType *datatype_int;
+    const DataType *datatype_float;
+    const DataType *datatype_boolean;
+    Uint32 num_datatypes;
+    DataType datatypes[NUM_BUILTIN_DATATYPES];
+} BuiltinDataTypes;
+
+static BuiltinDataTypes builtin_datatypes_storage;
+static void *builtin_datatypes = NULL;  /* points to builtin_datatypes_storage once it's ready to use. */
+static SDL_SpinLock builtin_datatypes_lock = 0;
+
+static DataType *add_builtin_datatype(BuiltinDataTypes *builtins, const char *name, const DataTypeType dtt)
+{
+    const char *strcached = stringcache(builtins->strcache, name);
+    DataType *dt;
+
+    SDL_assert(builtins->num_datatypes < SDL_arraysize(builtins->datatypes));
+
+    if (!strcached) {
+        return NULL;
+    }
+
+    dt = &builtins->datatypes[builtins->num_datatypes];
+    dt->name = strcached;
+    dt->dtype = dtt;
+    SDL_zero(dt->info);
+    if (hash_insert(builtins->table, strcached, dt) != 1) {
+        return NULL;
+    }
+
+    builtins->num_datatypes++;
+    return dt;
+}
+
+static void builtin_datatypes_nuke(const void *key, const void *value, void *data)
+{
+    /* nothing to do: the key is in the builtins' strcache, and the value is in builtin_datatypes_storage. */
+}
+
+static SDL_bool build_builtin_datatypes(BuiltinDataTypes *builtins)
+{
+    static const struct { DataTypeType dtt; const char *name; } base_types[NUM_BUILTIN_SCALAR_DATATYPES] = {
+        { DT_BOOLEAN, "bool" }, { DT_INT, "int" }, { DT_UINT, "uint" },
+        { DT_HALF, "half" }, { DT_FLOAT, "float" }
+    };
+
+    char name[32];
+    Uint32 i, j, k;
+
+    SDL_zerop(builtins);
+    builtins->strcache = stringcache_create(SDL_SHADER_internal_malloc, SDL_SHADER_internal_free, NULL);
+    builtins->table = hash_create(NULL, hash_hash_atom, hash_keymatch_atom_any_cache, builtin_datatypes_nuke, SDL_FALSE, SDL_SHADER_internal_malloc, SDL_SHADER_internal_free, NULL);
+    if (!builtins->strcache || !builtins->table) {
+        return SDL_FALSE;
+    }
+
+    for (i = 0; i < SDL_arraysize(base_types); i++) {
+        const DataType *scalar = add_builtin_datatype(builtins, base_types[i].name, base_types[i].dtt);
+        if (!scalar) {
+            return SDL_FALSE;  /* out of memory. */
+        }
+
+        switch (base_types[i].dtt) {
+            case DT_INT: builtins->datatype_int = scalar; break;
+            case DT_FLOAT: builtins->datatype_float = scalar; break;
+            case DT_BOOLEAN: builtins->datatype_boolean = scalar; break;
+            default: break;
+        }
+
+        for (j = 2; j <= 4; j++) {
+            DataType *vector;
+            SDL_snprintf(name, sizeof (name), "%s%d", base_types[i].name, j);
+            vector = add_builtin_datatype(builtins, name, DT_VECTOR);
+            if (!vector) {
+                return SDL_FALSE;  /* out of memory. */
+            }
+            vector->info.vector.childdt = scalar;
+            vector->info.vector.elements = j;
+
+            for (k = 2; k <= 4; k++) {
+                DataType *matrix;
+                SDL_snprintf(name, sizeof (name), "%s%dx%d", base_types[i].name, j, k);
+                matrix = add_builtin_datatype(builtins, name, DT_MATRIX);
+                if (!matrix) {
+                    return SDL_FALSE;  /* out of memory. */
+                }
+                matrix->info.matrix.childdt = vector;
+                matrix->info.matrix.rows = k;
+            }
+        }
+    }
+
+    SDL_assert(builtins->num_datatypes == NUM_BUILTIN_DATATYPES);
+    return SDL_TRUE;
+}
+
+static const BuiltinDataTypes *get_builtin_datatypes(void)
+{
+    BuiltinDataTypes *retval = (BuiltinDataTypes *) SDL_AtomicGetPtr(&builtin_datatypes);
+    if (retval == NULL) {  /* not built yet? Take the lock and check again, in case another thread beat us to it. */
+        SDL_AtomicLock(&builtin_datatypes_lock);
+        retval = (BuiltinDataTypes *) SDL_AtomicGetPtr(&builtin_datatypes);
+        if (retval == NULL) {
+            if (build_builtin_datatypes(&builtin_datatypes_storage)) {
+                retval = &builtin_datatypes_storage;
+                SDL_AtomicSetPtr(&builtin_datatypes, retval);
+            } else {  /* out of memory; throw it all away, maybe next time will work. */
+                if (builtin_datatypes_storage.table) {
+                    hash_destroy(builtin_datatypes_storage.table);
+                }
+                stringcache_destroy(builtin_datatypes_storage.strcache);
+                SDL_zero(builtin_datatypes_storage);
+            }
+        }
+        SDL_AtomicUnlock(&builtin_datatypes_lock);
+    }
+    return retval;
+}
+
+/* builtin types are shared (see get_builtin_datatypes), so this is only for user types, in ctx->datatypes. */
 static DataType *alloc_datatype(Context *ctx, const char *name, const DataTypeType dtt)
 {
     DataType *dt = NULL;
     const char *strcached = stringcache(ctx->strcache, name);
+
+    if (ctx->datatypes == NULL) {
+        /* datatype names are all strcache'd, so we can hash and compare them as atoms. */
+        ctx->datatypes = hash_create(ctx, hash_hash_atom, hash_keymatch_atom, datatypes_nuke, SDL_FALSE, MallocContextBridge, FreeContextBridge, ctx);
+        if (ctx->datatypes == NULL) {
+            return NULL;
+        }
+    }
+
     if (strcached) {
         dt = (DataType *) Malloc(ctx, sizeof (DataType));
         if (dt) {
@@ -207,32 +349,21 @@ static DataType *alloc_datatype(Context *ctx, const char *name, const DataTypeTy
     return dt;
 }
 
-static const DataType *add_scalar_datatype(Context *ctx, const char *name, const DataTypeType dtt)
+/* `name` must be strcache'd! */
+static SDL_bool is_builtin_datatype(Context *ctx, const char *name)
 {
-    return alloc_datatype(ctx, name, dtt);
+    return (ctx->builtin_datatypes && hash_find(ctx->builtin_datatypes, name, NULL)) ? SDL_TRUE : SDL_FALSE;
 }
 
-static const DataType *add_vector_datatype(Context *ctx, const char *name, const DataType *childdt, const Uint32 elements)
+/* `name` must be strcache'd! */
+static SDL_bool find_datatype(Context *ctx, const char *name, const DataType **_dt)
 {
-    DataType *dt = alloc_datatype(ctx, name, DT_VECTOR);
-    if (dt) {
-        dt->info.vector.childdt = childdt;
-        dt->info.vector.elements = elements;
+    if (ctx->datatypes && hash_find(ctx->datatypes, name, (const void **) _dt)) {
+        return SDL_TRUE;
     }
-    return dt;
+    return (ctx->builtin_datatypes && hash_find(ctx->builtin_datatypes, name, (const void **) _dt)) ? SDL_TRUE : SDL_FALSE;
 }
 
-static const DataType *add_matrix_datatype(Context *ctx, const char *name, const DataType *childdt, const Uint32 rows)
-{
-    DataType *dt = alloc_datatype(ctx, name, DT_MATRIX);
-    ICE_IF(ctx, &ctx->ast_before, childdt->dtype != DT_VECTOR, "Created a matrix that doesn't contain vectors");
-    if (dt) {
-        dt->info.matrix.childdt = childdt;
-        dt->info.matrix.rows = rows;
-    }
-    return dt;
-}
-        
 static const DataType *add_array_datatype(Context *ctx, const char *name, const DataType *childdt, const Uint32 elements)
 {
     DataType *dt = alloc_datatype(ctx, name, DT_ARRAY);
@@ -246,7 +377,7 @@ static const DataType *add_array_datatype(Context *ctx, const char *name, const
 static const DataType *resolve_datatype(Context *ctx, const SDL_SHADER_AstNodeInfo *ast, const char *name)
 {
     const DataType *dt = NULL;
-    if (!hash_find(ctx->datatypes, name, (const void **) &dt)) {
+    if (!find_datatype(ctx, name, &dt)) {
         failf_ast(ctx, ast, "Unknown data type '%s'", name);
         dt = ctx->datatype_int;
     } else if (dt == NULL) {
@@ -284,7 +415,11 @@ static void add_global_user_datatypes(Context *ctx)
     }
 
     for (i = ctx->structs; i != NULL; i = i->nextstruct) {
-        alloc_datatype(ctx, i->name, DT_STRUCT);  /* add all the structs first, uninitialized, so they can reference each other in any order. */
+        if (is_builtin_datatype(ctx, i->name)) {
+            failf_ast(ctx, &i->ast, "Cannot redefine built-in datatype '%s'", i->name);
+        } else {
+            alloc_datatype(ctx, i->name, DT_STRUCT);  /* add all the structs first, uninitialized, so they can reference each other in any order. */
+        }
     }
 
     for (i = ctx->structs; i != NULL; i = i->nextstruct) {
@@ -293,8 +428,8 @@ static void add_global_user_datatypes(Context *ctx)
         SDL_SHADER_AstStructMember *mem;
         DataType *dt = NULL;
 
-        if (!hash_find(ctx->datatypes, i->name, (const void **) &dt)) {
-            ICE_IF(ctx, &ctx->ast_before, !ctx->out_of_memory, "Failed to find a datatype we just added, and not out of memory!");  /* no other reason to be missing here, we just added it! */
+        if (!ctx->datatypes || !hash_find(ctx->datatypes, i->name, (const void **) &dt)) {
+            ICE_IF(ctx, &ctx->ast_before, !ctx->out_of_memory && !is_builtin_datatype(ctx, i->name), "Failed to find a datatype we just added, and not out of memory!");  /* no other reason to be missing here, we just added it! */
             continue;
         }
         ICE_IF(ctx, &ctx->ast_before, dt == NULL, "Successfully looked up a datatype, but it's NULL!");
@@ -318,7 +453,7 @@ static void add_global_user_datatypes(Context *ctx)
                     }
                     const char *arraydt_name = get_array_datatype_name(ctx, mem->datatype_name, iarraylen);  /* strcache'd. */
                     const DataType *arraydt = NULL;
-                    if (!hash_find(ctx->datatypes, arraydt_name, (const void **) &arraydt)) {
+                    if (!find_datatype(ctx, arraydt_name, &arraydt)) {
                         arraydt = add_array_datatype(ctx, arraydt_name, members[memidx].dt, iarraylen);
                     }
                     members[memidx].dt = arraydt;
@@ -326,53 +461,30 @@ static void add_global_user_datatypes(Context *ctx)
             }
             ICE_IF(ctx, &ctx->ast_before, memidx != num_members, "We created a struct datatype with an unexpected number of members!");
         }
-        dt->info.structure.num_members = num_members;
+        dt->info.structure.num_members = members ? num_members : 0;  /* out of memory? Leave it empty so nothing walks off the end. */
         dt->info.structure.members = members;
     }
 }
 
 static void semantic_analysis_gather_datatypes(Context *ctx)
 {
-    /* build a table of all available data types. This will be the intrinsic ones (float4x4, etc)
-       and any structs the program defined. */
-    static const struct { DataTypeType dtt; const char *name; } base_types[] = {
-        { DT_BOOLEAN, "bool" }, { DT_INT, "int" }, { DT_UINT, "uint" },
-        { DT_HALF, "half" }, { DT_FLOAT, "float" }
-    };
-
-    char name[32];
-    Uint32 i, j, k;
-
-    for (i = 0; i < SDL_arraysize(base_types); i++) {
-        const DataType *scalar = add_scalar_datatype(ctx, base_types[i].name, base_types[i].dtt);
-        if (!scalar) {
-            continue; /* out of memory, probably. */
-        }
-
-        switch (base_types[i].dtt) {
-            case DT_INT: ctx->datatype_int = scalar; break;
-            case DT_FLOAT: ctx->datatype_float = scalar; break;
-            case DT_BOOLEAN: ctx->datatype_boolean = scalar; break;
-            default: break;
-        }
-
-        for (j = 2; j <= 4; j++) {
-            SDL_snprintf(name, sizeof (name), "%s%d", base_types[i].name, j);
-            const DataType *vector = add_vector_datatype(ctx, name, scalar, j);
-            if (!vector) {
-                continue; /* out of memory, probably. */
-            }
-            for (k = 2; k <= 4; k++) {
-                SDL_snprintf(name, sizeof (name), "%s%dx%d", base_types[i].name, j, k);
-                add_matrix_datatype(ctx, name, vector, k);
-            }
-        }
+    /* build a table of all available data types. This will be the intrinsic ones (float4x4, etc),
+       which are shared between all contexts, and any structs the program defined layered on top. */
+    const BuiltinDataTypes *builtins = get_builtin_datatypes();
+    if (!builtins) {
+        ctx->isfail = ctx->out_of_memory = SDL_TRUE;
+        return;
     }
 
-    /* intrinsic types are added, now add any structs the program defined. */
+    ctx->builtin_datatypes = builtins->table;
+    ctx->datatype_int = builtins->datatype_int;
+    ctx->datatype_float = builtins->datatype_float;
+    ctx->datatype_boolean = builtins->datatype_boolean;
+
+    /* intrinsic types are ready, now add any structs the program defined. */
     add_global_user_datatypes(ctx);
 
-    /* Now that datatypes are added, always pull them from ctx->datatypes, so you can just
+    /* Now that datatypes are added, always pull them from find_datatype(), so you can just
        compare pointers to decide if a datatype is equal! */
 }
 
@@ -650,7 +762,7 @@ static const DataType *semantic_analysis_typecheck_swizzle(Context *ctx, const S
         SDL_snprintf(newtype, sizeof (newtype), "%s%d", expr->ast.dt->info.vector.childdt->name, (int) slen);
     }
 
-    if (!hash_find(ctx->datatypes, stringcache(ctx->strcache, newtype), (const void **) &retval)) {
+    if (!find_datatype(ctx, stringcache(ctx->strcache, newtype), &retval)) {
         ICE(ctx, &expr->ast, "Unexpected swizzled datatype!");
         return NULL;
     }
@@ -699,15 +811,9 @@ static void semantic_analysis_validate_function_param_at_attribute(Context *ctx,
 
 static ScopeItem *push_scope(Context *ctx, SDL_SHADER_AstNode *ast)
 {
-    ScopeItem *item;
-    if (ctx->scope_pool == NULL) {
-        item = (ScopeItem *) Malloc(ctx, sizeof (*item));
-        if (!item) {
-            return NULL;
-        }
-    } else {
-        item = ctx->scope_pool;
-        ctx->scope_pool = item->next;
+    ScopeItem *item = (ScopeItem *) pool_alloc(ctx->scope_pool);
+    if (!item) {
+        return NULL;
     }
 
     item->ast = ast;
@@ -720,10 +826,12 @@ static ScopeItem *push_scope(Context *ctx, SDL_SHADER_AstNode *ast)
 static void pop_scope(Context *ctx, ScopeItem *item)
 {
     if (item) {
-        ScopeItem *top_of_stack = ctx->scope_stack;
-        ctx->scope_stack = item->next;
-        item->next = ctx->scope_pool;
-        ctx->scope_pool = top_of_stack;
+        const ScopeItem *stop = item->next;
+        while (ctx->scope_stack != stop) {
+            ScopeItem *next = ctx->scope_stack->next;
+            pool_free(ctx->scope_pool, ctx->scope_stack);
+            ctx->scope_stack = next;
+        }
     }
 }
 
@@ -1134,7 +1242,7 @@ static void semantic_analysis_treewalk(Context *ctx, void *_ast)
 
             // !!! FIXME: } else { search intrinsic functions
 
-            } else if (hash_find(ctx->datatypes, name, (const void **) &fncall->ast.dt)) {  /* if the name is a datatype, this is a constructor. */
+            } else if (find_datatype(ctx, name, &fncall->ast.dt)) {  /* if the name is a datatype, this is a constructor. */
                 if (fncall->ast.dt == NULL) {
                     ICE(ctx, &ast->ast, "Successfully looked up datatype but the datatype turned out to be NULL!");
                     fncall->ast.dt = ctx->datatype_int;  /* oh well */
@@ -1399,7 +1507,7 @@ static void semantic_analysis_treewalk(Context *ctx, void *_ast)
         }
 
         case SDL_SHADER_AST_STRUCT_DECLARATION: /* we handled these in semantic_analysis_gather_datatypes, etc */
-            ICE_IF(ctx, &ast->ast, !ctx->scope_stack || (ctx->scope_stack->ast->ast.type != SDL_SHADER_AST_SHADER), "Unexpected struct declaration!");
+            ICE_IF(ctx, &ast->ast, !ctx->out_of_memory && (!ctx->scope_stack || (ctx->scope_stack->ast->ast.type != SDL_SHADER_AST_SHADER)), "Unexpected struct declaration!");
             return;  /* if we start to allow struct declarations outside of global scope, this will need to do something. */
 
         case SDL_SHADER_AST_SWITCH_CASE:  /* handled with SDL_SHADER_AST_STATEMENT_SWITCH */
@@ -1443,36 +1551,38 @@ static void datatypes_nuke(const void *key, const void *value, void *data)
     Free(ctx, dt);
 }
 
-/* since these keys are strcache'd, you can just compare the pointers instead of the contents. */
-int hash_keymatch_datatypes(const void *a, const void *b, void *data)
-{
-    (void) data;
-    return a == b;
-}
-
 
 void compiler_end(Context *ctx)
 {
-    ScopeItem *scope;
-    ScopeItem *scopenext;
-
-    if (!ctx || !ctx->uses_compiler) {
+    if (!ctx) {
         return;
     }
 
-    hash_destroy(ctx->datatypes);
+    if (ctx->uses_compiler) {
+        if (ctx->datatypes) {
+            hash_destroy(ctx->datatypes);
+            ctx->datatypes = NULL;
+        }
 
-    for (scope = ctx->scope_stack; scope != NULL; scope = scopenext) {
-        scopenext = scope->next;
-        Free(ctx, scope);
-    }
+        while (ctx->scope_stack) {  /* shouldn't happen, but put these back in the pool if it does. */
+            ScopeItem *next = ctx->scope_stack->next;
+            pool_free(ctx->scope_pool, ctx->scope_stack);
+            ctx->scope_stack = next;
+        }
 
-    for (scope = ctx->scope_pool; scope != NULL; scope = scopenext) {
-        scopenext = scope->next;
-        Free(ctx, scope);
+        Free(ctx, ctx->compile_output);
+        ctx->compile_output = NULL;
+        ctx->compile_output_len = 0;
+        ctx->functions = NULL;
+        ctx->structs = NULL;
+        ctx->uses_compiler = SDL_FALSE;
     }
 
-    ctx->uses_compiler = SDL_FALSE;
+    /* reusable contexts keep the scope pool for the next run. */
+    if (!ctx->reusable) {
+        pool_destroy(ctx->scope_pool);
+        ctx->scope_pool = NULL;
+    }
 }
 
 
@@ -1483,12 +1593,19 @@ static const SDL_SHADER_CompileData SDL_SHADER_out_of_mem_data_compile = {
 static const SDL_SHADER_CompileData *build_compiledata(Context *ctx)
 {
     SDL_SHADER_CompileData *retval = NULL;
+    const size_t error_count = errorlist_count(ctx->errors);
+    const size_t output_len = ctx->isfail ? 0 : ctx->compile_output_len;
+    SDL_SHADER_Error *errors = NULL;
+    void *output = NULL;
 
     if (ctx->out_of_memory) {
         return &SDL_SHADER_out_of_mem_data_compile;
     }
 
-    retval = (SDL_SHADER_CompileData *) Malloc(ctx, sizeof (SDL_SHADER_CompileData));
+    ctx->memphase = SDL_SHADER_MEMPHASE_OUTPUT;
+
+    /* the struct, errors, their strings and the output all go in one block, so the app can free it with one call. */
+    retval = (SDL_SHADER_CompileData *) errorlist_flatten(ctx->errors, sizeof (SDL_SHADER_CompileData), output_len, &errors, &output);
     if (retval == NULL) {
         return &SDL_SHADER_out_of_mem_data_compile;
     }
@@ -1497,37 +1614,29 @@ static const SDL_SHADER_CompileData *build_compiledata(Context *ctx)
     retval->malloc = (ctx->malloc == SDL_SHADER_internal_malloc) ? NULL : ctx->malloc;
     retval->free = (ctx->free == SDL_SHADER_internal_free) ? NULL : ctx->free;
     retval->malloc_data = ctx->malloc_data;
-    retval->error_count = errorlist_count(ctx->errors);
-    retval->errors = errorlist_flatten(ctx->errors);
-
-    if (ctx->out_of_memory) {
-        Free(ctx, retval);
-        return &SDL_SHADER_out_of_mem_data_compile;
-    }
+    retval->error_count = error_count;
+    retval->errors = errors;
 
     if (!ctx->isfail) {
         retval->source_profile = ctx->source_profile;
-        retval->output = ctx->compile_output;
-        retval->output_len = ctx->compile_output_len;
-        ctx->compile_output = NULL;  /* owned by retval now. Null out so we don't free it. */
-        ctx->compile_output_len = 0;
+        if (output_len > 0) {
+            SDL_memcpy(output, ctx->compile_output, output_len);
+            retval->output = (const Uint8 *) output;
+            retval->output_len = output_len;
+        }
     }
 
+    retval->memory = ctx->memstats;
+
+    Disown(ctx, retval);  /* the app owns this now, so stop counting it against the context. */
+
     return retval;
 }
 
 
-/* API entry point... */
-
-const SDL_SHADER_CompileData *SDL_SHADER_Compile(const SDL_SHADER_CompilerParams *params)
+static void compile_ast(Context *ctx, const SDL_SHADER_CompilerParams *params)
 {
-    const SDL_SHADER_CompileData *retval;
-    Context *ctx;
-
-    ctx = parse_to_ast(params);
-    if (ctx == NULL) {
-        return &SDL_SHADER_out_of_mem_data_compile;
-    }
+    ctx->memphase = SDL_SHADER_MEMPHASE_SEMANTIC;
 
     if (!ctx->isfail) {
         ctx->uses_compiler = SDL_TRUE;
@@ -1536,14 +1645,32 @@ const SDL_SHADER_CompileData *SDL_SHADER_Compile(const SDL_SHADER_CompilerParams
         ctx->ast_before.dt = ctx->ast_after.dt = NULL;
         ctx->ast_before.line = SDL_SHADER_POSITION_BEFORE;
         ctx->ast_after.line = SDL_SHADER_POSITION_AFTER;
-        ctx->datatypes = hash_create(ctx, hash_hash_string, hash_keymatch_datatypes, datatypes_nuke, SDL_FALSE, MallocContextBridge, FreeContextBridge, ctx);
+        ctx->datatypes = NULL;  /* created when we add the first user-defined datatype. */
         ctx->scope_stack = NULL;
-        ctx->scope_pool = NULL;
+        if (!ctx->scope_pool) {  /* reusable contexts might still have this from a previous run. */
+            ctx->scope_pool = pool_create(sizeof (ScopeItem), MallocContextBridge, FreeContextBridge, ctx);
+        }
     }
 
     if (!ctx->isfail) {
         semantic_analysis(ctx, params);
     }
+}
+
+
+/* API entry points... */
+
+const SDL_SHADER_CompileData *SDL_SHADER_Compile(const SDL_SHADER_CompilerParams *params)
+{
+    const SDL_SHADER_CompileData *retval;
+    Context *ctx;
+
+    ctx = parse_to_ast(NULL, params);
+    if (ctx == NULL) {
+        return &SDL_SHADER_out_of_mem_data_compile;
+    }
+
+    compile_ast(ctx, params);
 
     retval = build_compiledata(ctx);
     SDL_assert(retval != NULL);  /* should never return NULL, even if out of memory! */
@@ -1553,24 +1680,57 @@ const SDL_SHADER_CompileData *SDL_SHADER_Compile(const SDL_SHADER_CompilerParams
     return retval;
 }
 
+SDL_SHADER_Compiler *SDL_SHADER_CreateCompiler(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d)
+{
+    Context *ctx = context_create(m, f, d);
+    if (ctx != NULL) {
+        ctx->reusable = SDL_TRUE;
+    }
+    return (SDL_SHADER_Compiler *) ctx;
+}
+
+const SDL_SHADER_CompileData *SDL_SHADER_CompileWith(SDL_SHADER_Compiler *compiler, const SDL_SHADER_CompilerParams *params)
+{
+    const SDL_SHADER_CompileData *retval;
+    Context *ctx = (Context *) compiler;
+
+    if ((ctx == NULL) || !context_reset(ctx)) {
+        return &SDL_SHADER_out_of_mem_data_compile;
+    }
+
+    parse_to_ast(ctx, params);
+    compile_ast(ctx, params);
+
+    retval = build_compiledata(ctx);
+    SDL_assert(retval != NULL);  /* should never return NULL, even if out of memory! */
+
+    /* clean up this run, but leave the reusable stuff for next time. */
+    preprocessor_end(ctx);
+    ast_end(ctx);
+    compiler_end(ctx);
+    source_position_reset(ctx);  /* the errors already have their columns. */
+
+    return retval;
+}
+
+void SDL_SHADER_DestroyCompiler(SDL_SHADER_Compiler *compiler)
+{
+    Context *ctx = (Context *) compiler;
+    if (ctx != NULL) {
+        ctx->reusable = SDL_FALSE;  /* make everything really go away. */
+        context_destroy(ctx);
+    }
+}
+
 void SDL_SHADER_FreeCompileData(const SDL_SHADER_CompileData *_data)
 {
     SDL_SHADER_CompileData *data = (SDL_SHADER_CompileData *) _data;
     if ((data != NULL) && (data != &SDL_SHADER_out_of_mem_data_compile)) {
         SDL_SHADER_Free f = (data->free == NULL) ? SDL_SHADER_internal_free : data->free;
         void *d = data->malloc_data;
-        int i;
 
         /* we don't f(data->source_profile), because that's internal static data. */
-
-        for (i = 0; i < data->error_count; i++) {
-            f((void *) data->errors[i].message, d);
-            f((void *) data->errors[i].filename, d);
-        }
-
-        f((void *) data->errors, d);
-        f((void *) data->output, d);
-        f(data, d);
+        FreeReturnedData(f, d, data);  /* errors and output are in the same block. */
     }
 }
 
@@ -26,6 +26,21 @@ extern "C" {
 typedef void *(SDLCALL *SDL_SHADER_Malloc)(size_t bytes, void *data);
 typedef void (SDLCALL *SDL_SHADER_Free)(void *ptr, void *data);
 
+/*
+ * These are optional extras for a custom allocator.
+ *
+ * SDL_SHADER_Realloc grows (or shrinks) an allocation from oldbytes to
+ *  newbytes, like the C runtime's realloc(), so growable arrays can extend
+ *  in place when your allocator can manage it. (ptr) is never NULL and
+ *  (newbytes) is never zero. On failure, return NULL and leave (ptr) alone.
+ *
+ * SDL_SHADER_SizedFree works like SDL_SHADER_Free, but also tells you how
+ *  many bytes the allocation was, so your allocator doesn't have to track
+ *  that itself.
+ */
+typedef void *(SDLCALL *SDL_SHADER_Realloc)(void *ptr, size_t oldbytes, size_t newbytes, void *data);
+typedef void (SDLCALL *SDL_SHADER_SizedFree)(void *ptr, size_t bytes, void *data);
+
 
 /*
  * These are used with SDL_SHADER_error as special case positions.
@@ -61,9 +76,60 @@ typedef struct SDL_SHADER_Error
      *  an error during final processing.
      */
     Sint32 error_position;
+
+    /*
+     * Column of the error on that line, counted in bytes and starting at 1.
+     *  Will be 0 if it isn't known.
+     */
+    Sint32 error_column;
 } SDL_SHADER_Error;
 
 
+/*
+ * Memory usage, for apps that want to keep an eye on what a shader costs.
+ *
+ * Every allocation is charged to the phase of processing that made it, even
+ *  if a later phase frees it. Byte counts are what we requested from your
+ *  allocator (including a little bookkeeping per allocation), not counting
+ *  whatever overhead your allocator adds itself.
+ */
+typedef enum SDL_SHADER_MemoryPhase
+{
+    SDL_SHADER_MEMPHASE_PREPROCESS,  /* preprocessing and lexing. */
+    SDL_SHADER_MEMPHASE_PARSE,       /* building the syntax tree. */
+    SDL_SHADER_MEMPHASE_SEMANTIC,    /* semantic analysis. */
+    SDL_SHADER_MEMPHASE_OUTPUT,      /* building the data we return to you. */
+    SDL_SHADER_NUM_MEMPHASES
+} SDL_SHADER_MemoryPhase;
+
+typedef struct SDL_SHADER_MemoryUsage
+{
+    /*
+     * Bytes still allocated when the returned data was built, which
+     *  includes the returned data itself.
+     */
+    size_t current_bytes;
+
+    /* The most bytes that were allocated at one time. */
+    size_t peak_bytes;
+
+    /* The number of allocations made. */
+    size_t allocations;
+} SDL_SHADER_MemoryUsage;
+
+typedef struct SDL_SHADER_MemoryStats
+{
+    /* Usage per phase, indexed by SDL_SHADER_MemoryPhase. */
+    SDL_SHADER_MemoryUsage phases[SDL_SHADER_NUM_MEMPHASES];
+
+    /*
+     * Usage of all phases together. Note that total.peak_bytes is the real
+     *  high-water mark, which can be less than the sum of each phase's peak.
+     */
+    SDL_SHADER_MemoryUsage total;
+} SDL_SHADER_MemoryStats;
+
+
 /* Preprocessor interface... */
 
 /*
@@ -118,6 +184,9 @@ typedef struct SDL_SHADER_PreprocessData
 
     /* This is the pointer you passed as opaque data for your allocator. */
     void *malloc_data;
+
+    /* How much memory preprocessing took. */
+    SDL_SHADER_MemoryStats memory;
 } SDL_SHADER_PreprocessData;
 
 
@@ -207,6 +276,8 @@ typedef struct SDL_SHADER_CompilerParams
     SDL_SHADER_Malloc allocate;
     SDL_SHADER_Free deallocate;
     void *allocate_data;
+    SDL_SHADER_Realloc reallocate;  /* optional, ignored unless `allocate` and `deallocate` are set, too. */
+    SDL_SHADER_SizedFree sized_deallocate;  /* optional, ignored unless `allocate` and `deallocate` are set, too. */
 } SDL_SHADER_CompilerParams;
 
 
@@ -227,7 +298,9 @@ typedef struct SDL_SHADER_CompilerParams
  *  too.
  *
  * (source) is an string of UTF-8 text to preprocess. It does not need to be
- *  NULL-terminated.
+ *  NULL-terminated. Invalid UTF-8, here or in an #included file, gets a
+ *  warning (just the first bad sequence in each file), but isn't an error by
+ *  itself.
  *
  * (sourcelen) is the length of the string pointed to by (source), in bytes.
  *
@@ -250,10 +323,16 @@ typedef struct SDL_SHADER_CompilerParams
  *
  * As preprocessing requires some memory to be allocated, you may provide a
  *  custom allocator to this function, which will be used to allocate/free
- *  memory. They function just like malloc() and free(). We do not use
- *  realloc(). If you don't care, pass NULL in for the allocator functions.
- *  If your allocator needs instance-specific data, you may supply it with the
- *  (d) parameter. This pointer is passed as-is to your (m) and (f) functions.
+ *  memory. They function just like malloc() and free(). If you don't care,
+ *  pass NULL in for the allocator functions. If your allocator needs
+ *  instance-specific data, you may supply it with the (d) parameter. This
+ *  pointer is passed as-is to your (m) and (f) functions.
+ *
+ * If you supply a custom allocator, you can also supply (reallocate), which
+ *  we use to grow arrays, and (sized_deallocate), which we use instead of
+ *  (deallocate) for freeing our internal memory. Either can be NULL. Returned
+ *  data is always freed with (deallocate), so all of these must work on the
+ *  same heap.
  *
  * This function is thread safe, so long as the various callback functions
  *  are, too, and that the parameters remains intact for the duration of the
@@ -262,10 +341,51 @@ typedef struct SDL_SHADER_CompilerParams
  */
 extern DECLSPEC const SDL_SHADER_PreprocessData * SDLCALL SDL_SHADER_Preprocess(const SDL_SHADER_CompilerParams *params, SDL_bool strip_comments);
 
+
+/*
+ * One piece of output, for SDL_SHADER_OutputSink. This is laid out like
+ *  POSIX's struct iovec, but in the opposite order, so copy the fields over
+ *  instead of casting.
+ */
+typedef struct SDL_SHADER_OutputChunk
+{
+    const void *data;
+    size_t len;
+} SDL_SHADER_OutputChunk;
+
+/*
+ * This callback receives output directly from our internal buffers, so it
+ *  never has to be copied into one big string first.
+ *
+ * (chunks) points to (chunk_count) pieces of output, in order. Together they
+ *  make up the whole output; they are not NULL-terminated, and they are only
+ *  valid until this callback returns. (userdata) is whatever you passed
+ *  along with the callback.
+ *
+ * Return SDL_FALSE if you couldn't handle the output (a failed write, etc),
+ *  and an error will be added to the results.
+ */
+typedef SDL_bool (SDLCALL *SDL_SHADER_OutputSink)(const SDL_SHADER_OutputChunk *chunks, size_t chunk_count, void *userdata);
+
+/*
+ * This works just like SDL_SHADER_Preprocess(), but instead of putting the
+ *  output in the returned SDL_SHADER_PreprocessData, it hands it to (sink),
+ *  with (userdata), just before returning. This saves making a copy of the
+ *  output, which for large shaders can halve the memory needed.
+ *
+ * (sink) is called once, even if preprocessing reported errors, with the same
+ *  output SDL_SHADER_Preprocess() would have returned; check the results'
+ *  (error_count) to decide if you want to keep it. It is not called if we
+ *  ran out of memory. The returned data's (output) will always be NULL, but
+ *  (output_len) is still the total number of bytes of output.
+ */
+extern DECLSPEC const SDL_SHADER_PreprocessData * SDLCALL SDL_SHADER_PreprocessToSink(const SDL_SHADER_CompilerParams *params, SDL_bool strip_comments, SDL_SHADER_OutputSink sink, void *userdata);
+
 /*
  * Call this to dispose of preprocessing results when you are done with them.
  *  This will call the SDL_SHADER_free function you provided to
- *  SDL_SHADER_Preprocess() multiple times, if you provided one.
+ *  SDL_SHADER_Preprocess() once, if you provided one, since the results
+ *  are all packed into a single allocation.
  *  Passing a NULL here is a safe no-op.
  *
  * This function is thread safe, so long as any allocator you passed into
@@ -321,6 +441,11 @@ typedef struct SDL_SHADER_CompileData
      * This is the pointer you passed as opaque data for your allocator.
      */
     void *malloc_data;
+
+    /*
+     * How much memory compiling took.
+     */
+    SDL_SHADER_MemoryStats memory;
 } SDL_SHADER_CompileData;
 
 
@@ -338,7 +463,8 @@ typedef struct SDL_SHADER_CompileData
  *  too.
  *
  * (source) is an UTF-8 string of valid high-level shader source code.
- *  It does not need to be NULL-terminated.
+ *  It does not need to be NULL-terminated. Invalid UTF-8 gets a warning, as
+ *  with SDL_SHADER_Preprocess().
  *
  * (sourcelen) is the length of the string pointed to by (source), in bytes.
  *
@@ -361,10 +487,16 @@ typedef struct SDL_SHADER_CompileData
  *
  * As compiling requires some memory to be allocated, you may provide a
  *  custom allocator to this function, which will be used to allocate/free
- *  memory. They function just like malloc() and free(). We do not use
- *  realloc(). If you don't care, pass NULL in for the allocator functions.
- *  If your allocator needs instance-specific data, you may supply it with the
- *  (d) parameter. This pointer is passed as-is to your (m) and (f) functions.
+ *  memory. They function just like malloc() and free(). If you don't care,
+ *  pass NULL in for the allocator functions. If your allocator needs
+ *  instance-specific data, you may supply it with the (d) parameter. This
+ *  pointer is passed as-is to your (m) and (f) functions.
+ *
+ * If you supply a custom allocator, you can also supply (reallocate), which
+ *  we use to grow arrays, and (sized_deallocate), which we use instead of
+ *  (deallocate) for freeing our internal memory. Either can be NULL. Returned
+ *  data is always freed with (deallocate), so all of these must work on the
+ *  same heap.
  *
  * This function is thread safe, so long as the various callback functions
  *  are, too, and that the parameters remains intact for the duration of the
@@ -377,7 +509,8 @@ extern DECLSPEC const SDL_SHADER_CompileData * SDLCALL SDL_SHADER_Compile(const
 /*
  * Call this to dispose of compile results when you are done with them.
  *  This will call the SDL_SHADER_Free function you provided to
- *  SDL_SHADER_Compile() multiple times, if you provided one.
+ *  SDL_SHADER_Compile() once, if you provided one, since the results
+ *  are all packed into a single allocation.
  *  Passing a NULL here is a safe no-op.
  *
  * This function is thread safe, so long as any allocator you passed into
@@ -385,6 +518,59 @@ extern DECLSPEC const SDL_SHADER_CompileData * SDLCALL SDL_SHADER_Compile(const
  */
 extern DECLSPEC void SDLCALL SDL_SHADER_FreeCompileData(const SDL_SHADER_CompileData *data);
 
+
+/*
+ * An opaque compiler session, for apps that compile many shaders.
+ *
+ * SDL_SHADER_Compile() builds and tears down all its internal state (memory
+ *  arenas, the parser, the table of built-in datatypes, etc) on every call.
+ *  A compiler session keeps this state between compiles, so after the first
+ *  shader, compiling mostly recycles memory instead of allocating it.
+ */
+typedef struct SDL_SHADER_Compiler SDL_SHADER_Compiler;
+
+/*
+ * Create a compiler session.
+ *
+ * (m), (f), and (d) are the allocator for the session, and work just like
+ *  they do in SDL_SHADER_CompilerParams. Everything the session allocates,
+ *  including the results of SDL_SHADER_CompileWith(), uses this allocator.
+ *  If you don't care, pass NULL in for the allocator functions.
+ *
+ * There's no way to give a session the optional (reallocate) and
+ *  (sized_deallocate) hooks, so it grows arrays with (m) and frees
+ *  everything with (f).
+ *
+ * Returns NULL if out of memory.
+ *
+ * A session is not thread safe; if you want to compile on several CPU cores
+ *  at the same time, create one session per thread.
+ */
+extern DECLSPEC SDL_SHADER_Compiler * SDLCALL SDL_SHADER_CreateCompiler(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d);
+
+/*
+ * Compile a shader using a compiler session.
+ *
+ * This works exactly like SDL_SHADER_Compile(), except the allocator fields
+ *  in (params), including (reallocate) and (sized_deallocate), are ignored in
+ *  favor of the session's allocator.
+ *
+ * The returned data does not depend on the session, and is still freed with
+ *  SDL_SHADER_FreeCompileData(), before or after the session is destroyed.
+ *
+ * If (compiler) is NULL (say, SDL_SHADER_CreateCompiler() ran out of memory),
+ *  this returns the usual out-of-memory results.
+ *
+ * This function will never return NULL.
+ */
+extern DECLSPEC const SDL_SHADER_CompileData * SDLCALL SDL_SHADER_CompileWith(SDL_SHADER_Compiler *compiler, const SDL_SHADER_CompilerParams *params);
+
+/*
+ * Destroy a compiler session, freeing all its internal state.
+ *  Passing a NULL here is a safe no-op.
+ */
+extern DECLSPEC void SDLCALL SDL_SHADER_DestroyCompiler(SDL_SHADER_Compiler *compiler);
+
 #ifdef __cplusplus
 }
 #endif
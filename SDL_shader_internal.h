@@ -79,6 +79,10 @@ SDL_bool hash_find(const HashTable *table, const void *key, const void **_value)
 SDL_bool hash_iter(const HashTable *table, const void *key, const void **_value, void **iter);
 SDL_bool hash_iter_keys(const HashTable *table, const void **_key, void **iter);
 
+/* Every string hash in the project uses this, so a hash computed in one
+   place (like the lexer, for identifiers) can be reused in another. */
+Uint32 hash_string(const char *str, size_t len);
+
 Uint32 hash_hash_string(const void *sym, void *unused);
 int hash_keymatch_string(const void *a, const void *b, void *unused);
 
@@ -100,28 +104,74 @@ typedef struct StringCache StringCache;
 StringCache *stringcache_create(SDL_SHADER_Malloc m,SDL_SHADER_Free f,void *d);
 const char *stringcache(StringCache *cache, const char *str);
 const char *stringcache_len(StringCache *cache, const char *str, const size_t len);
+const char *stringcache_len_hash(StringCache *cache, const char *str, const size_t len, const Uint32 hash);  /* hash must be hash_string(str, len)! */
 const char *stringcache_fmt(StringCache *cache, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(2);
 SDL_bool stringcache_iscached(StringCache *cache, const char *str);
+void stringcache_reset(StringCache *cache);  /* forget every string, but keep the memory for reuse. */
 void stringcache_destroy(StringCache *cache);
 
+/* Strings returned by a StringCache are "atoms": unique per cache, so they
+   compare by pointer, and they know their own hash, length and a small id
+   (starting at 1) without rescanning the string. Only pass strings that came
+   from a StringCache to these! NULL is allowed and returns 0. */
+Uint32 stringcache_atom_id(const char *atom);
+Uint32 stringcache_atom_hash(const char *atom);
+size_t stringcache_atom_len(const char *atom);
+
+/* Use these for hashtables whose keys are all atoms. */
+Uint32 hash_hash_atom(const void *sym, void *unused);
+int hash_keymatch_atom(const void *a, const void *b, void *unused);
+
+/* Use this instead of hash_keymatch_atom if the table is looked up with atoms
+   from a different StringCache than its keys came from. */
+int hash_keymatch_atom_any_cache(const void *a, const void *b, void *unused);
+
 
 /* Error lists... */
 
 typedef struct ErrorList ErrorList;
-ErrorList *errorlist_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d);
-SDL_bool errorlist_add(ErrorList *list, const SDL_bool is_error, const char *fname, const Sint32 errpos, const char *str);
-SDL_bool errorlist_add_fmt(ErrorList *list, const SDL_bool is_error, const char *fname, const Sint32 errpos, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(5);
-SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *_fname, const Sint32 errpos, SDL_PRINTF_FORMAT_STRING const char *fmt, va_list va);
+ErrorList *errorlist_create(SDL_SHADER_Malloc m, SDL_SHADER_Realloc r, SDL_SHADER_Free f, void *d);  /* r can be NULL. */
+SDL_bool errorlist_add(ErrorList *list, const SDL_bool is_error, const char *fname, const Sint32 errpos, const Sint32 errcol, const char *str);
+SDL_bool errorlist_add_fmt(ErrorList *list, const SDL_bool is_error, const char *fname, const Sint32 errpos, const Sint32 errcol, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(6);
+SDL_bool errorlist_add_va(ErrorList *list, const SDL_bool is_error, const char *_fname, const Sint32 errpos, const Sint32 errcol, SDL_PRINTF_FORMAT_STRING const char *fmt, va_list va);
 size_t errorlist_count(ErrorList *list);
-SDL_SHADER_Error *errorlist_flatten(ErrorList *list); // resets the list!
+/* This packs a result struct of `structlen` bytes, an array of all the list's
+   errors (and their strings), and `extralen` more bytes for the caller to
+   fill in, into one allocation, so the app can free it all with one call.
+   The struct is at the start of the block; (*_errors) is NULL if there were
+   no errors, (*_extra) is NULL if `extralen` is zero. Returns NULL and leaves
+   the list alone if out of memory, otherwise it resets the list! */
+void *errorlist_flatten(ErrorList *list, const size_t structlen, const size_t extralen, SDL_SHADER_Error **_errors, void **_extra);
 void errorlist_destroy(ErrorList *list);
 
 
 
+/* Memory arenas: bump-pointer allocation out of big chunks, freed all at once. */
+
+typedef struct MemArena MemArena;
+MemArena *arena_create(size_t chunksz, SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d);
+void *arena_alloc(MemArena *arena, const size_t len);
+void arena_reset(MemArena *arena);  /* frees all allocations, but keeps chunks around for reuse. */
+void arena_destroy(MemArena *arena);
+
+
+/* Memory pools: fixed-size objects from cache-line-aligned pages, with a free list for reuse. */
+
+typedef struct MemPool MemPool;
+MemPool *pool_create(const size_t objsize, SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d);
+void *pool_alloc(MemPool *pool);  /* not zeroed! */
+void pool_free(MemPool *pool, void *obj);
+void pool_destroy(MemPool *pool);  /* frees everything allocated from the pool, too. */
+
+
 /* Dynamic buffers... */
 
 typedef struct Buffer Buffer;
+typedef struct BufferPool BufferPool;  /* recycles Buffers and their blocks. */
+BufferPool *bufferpool_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d);
+void bufferpool_destroy(BufferPool *bufpool);  /* destroy every Buffer created from the pool first! */
 Buffer *buffer_create(size_t blksz, SDL_SHADER_Malloc m,SDL_SHADER_Free f,void *d);
+Buffer *buffer_create_pooled(size_t blksz, BufferPool *bufpool);  /* blksz is the first block's size; later blocks grow. */
 char *buffer_reserve(Buffer *buffer, const size_t len);
 SDL_bool buffer_append(Buffer *buffer, const void *_data, size_t len);
 SDL_bool buffer_append_fmt(Buffer *buffer, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(2);
@@ -129,6 +179,9 @@ SDL_bool buffer_append_va(Buffer *buffer, SDL_PRINTF_FORMAT_STRING const char *f
 size_t buffer_size(Buffer *buffer);
 void buffer_empty(Buffer *buffer);
 char *buffer_flatten(Buffer *buffer);
+char *buffer_flatten_padded(Buffer *buffer, const size_t padding);  /* like buffer_flatten(), but with `padding` null bytes at the end instead of one. */
+void buffer_flatten_into(Buffer *buffer, char *dst);  /* dst must have buffer_size()+1 bytes; empties the buffer. */
+size_t buffer_iovec(Buffer *buffer, SDL_SHADER_OutputChunk *iov, const size_t iovcount);  /* fills in up to iovcount blocks; returns the total number of blocks. */
 char *buffer_merge(Buffer **buffers, const size_t n, size_t *_len);
 void buffer_destroy(Buffer *buffer);
 ssize_t buffer_find(Buffer *buffer, const size_t start, const void *data, const size_t len);
@@ -252,6 +305,9 @@ typedef struct IncludeState
     size_t orig_length;
     size_t bytes_left;
     Sint32 line;
+    Uint32 tokenhash;  /* hash_string() of the token, only valid for TOKEN_IDENTIFIER. */
+    size_t position_base;  /* source position of source_base, 0 if this isn't a file (like a macro expansion). */
+    size_t invocation_position;  /* for macro expansions, the source position of the macro's name where it was used. */
     Conditional *conditional_stack;
     SDL_SHADER_IncludeClose close_callback;
     const Define *current_define;
@@ -259,6 +315,7 @@ typedef struct IncludeState
 } IncludeState;
 
 Token preprocessor_lexer(IncludeState *s);  /* this is the interface to the re2c-generated code. */
+#define LEXER_PADDING 8  /* the lexer's input must be followed by this many null bytes, so it never checks for the end. */
 
 void SDL_SHADER_print_debug_token(const char *subsystem, const char *token, const size_t tokenlen, const Token tokenval);
 
@@ -317,6 +374,21 @@ struct SDL_SHADER_AstDataType
     } info;
 };
 
+/* Every file the preprocessor reads gets its own range of source positions,
+   so a single size_t can say where any token came from (0 means nowhere).
+   Positions are only turned into columns when an error needs one, so a file's
+   line starts aren't found until then (or until the file is popped, if the
+   AST might still ask about it later). */
+typedef struct LineIndex
+{
+    size_t base;  /* source position of the file's first byte. */
+    size_t length;
+    const char *source;  /* the padded source, until `starts` is built or the file is popped. */
+    Uint32 count;
+    Uint32 *starts;  /* byte offset of each line, NULL until something needs it. */
+    struct LineIndex *next;
+} LineIndex;
+
 typedef struct ScopeItem
 {
     SDL_SHADER_AstNode *ast;
@@ -327,12 +399,20 @@ typedef struct Context
 {
     SDL_bool isfail;
     SDL_bool out_of_memory;
+    SDL_bool reusable;  /* SDL_TRUE if this is an SDL_SHADER_Compiler, kept between compiles. */
     SDL_SHADER_Malloc malloc;
     SDL_SHADER_Free free;
     void *malloc_data;
+    SDL_SHADER_Realloc realloc;  /* optional, NULL to malloc/copy/free instead. */
+    SDL_SHADER_SizedFree sized_free;  /* optional, NULL to use `free` instead. */
     const char *filename;  /* comes from a stringcache, don't free or modify it! */
     Sint32 position;
+    size_t source_position;  /* where the current token came from, for error columns. */
+    size_t next_source_position;
+    LineIndex *line_indexes;  /* these live until the next run, since AST nodes refer to them. */
     ErrorList *errors;
+    SDL_SHADER_MemoryPhase memphase;  /* Malloc() charges allocations to this phase. */
+    SDL_SHADER_MemoryStats memstats;
 
     /* preprocessor stuff... */
     SDL_bool uses_preprocessor;
@@ -340,11 +420,12 @@ typedef struct Context
     SDL_bool parsing_pragma;
     SDL_bool allow_dotdot_includes;  /* if SDL_FALSE, fail on `#include "path/with/../in/it"` */
     SDL_bool allow_absolute_includes;  /* if SDL_FALSE, fail on `#include "/absolute/path"` */
-    Conditional *conditional_pool;
+    MemPool *conditional_pool;
     IncludeState *include_stack;
-    IncludeState *include_pool;
+    MemPool *include_pool;
     Define *define_hashtable[256];
-    Define *define_pool;
+    MemPool *define_pool;
+    BufferPool *buffer_pool;  /* macro expansion and output buffers recycle their blocks here. */
     Define *file_macro;
     Define *line_macro;
     StringCache *filename_cache;
@@ -359,21 +440,26 @@ typedef struct Context
     SDL_bool uses_ast;
     const char *source_profile;  /* static string, don't free */
     SDL_SHADER_AstShader *shader;  /* Abstract Syntax Tree */
+    MemArena *ast_arena;  /* every AST node lives in here. */
     StringCache *strcache;
+    const char *ast_filename;  /* ctx->filename, copied into strcache, since AST nodes outlive the preprocessor. */
+    const char *ast_filename_source;  /* the ctx->filename that ast_filename is a copy of. */
+    void *parser;  /* lemon parser state, kept around if the context is reusable. */
 
     /* compiler stuff... */
     SDL_bool uses_compiler;
     SDL_bool isiced;  /* triggered an Internal Compiler Error. */
     SDL_SHADER_AstFunction *functions;  /* global function linked list, linked on nextfn (do not free) */
     SDL_SHADER_AstStructDeclaration *structs;  /* global struct decl linked list, linked on nextstruct (do not free) */
-    HashTable *datatypes;
+    const HashTable *builtin_datatypes;  /* intrinsic types (float4, etc), shared by every context. Read-only! */
+    HashTable *datatypes;  /* types the program defined (structs, arrays), created on first use. */
     SDL_SHADER_AstNodeInfo ast_before;  /* for fail_ast's use, for errors that count as "before" the source file */
     SDL_SHADER_AstNodeInfo ast_after;  /* for fail_ast's use, for errors that count as "after" the source file */
-    const DataType *datatype_int;  /* just a pointer to a value in datatypes (do not free) */
-    const DataType *datatype_float;  /* just a pointer to a value in datatypes (do not free) */
-    const DataType *datatype_boolean;  /* just a pointer to a value in datatypes (do not free) */
+    const DataType *datatype_int;  /* just a pointer to a value in builtin_datatypes (do not free) */
+    const DataType *datatype_float;  /* just a pointer to a value in builtin_datatypes (do not free) */
+    const DataType *datatype_boolean;  /* just a pointer to a value in builtin_datatypes (do not free) */
     ScopeItem *scope_stack;
-    ScopeItem *scope_pool;
+    MemPool *scope_pool;
     Uint8 *compile_output;
     size_t compile_output_len;
 
@@ -392,35 +478,102 @@ typedef struct Context
 } Context;
 
 Context *context_create(SDL_SHADER_Malloc m, SDL_SHADER_Free f, void *d);
+Context *context_create_from_params(const SDL_SHADER_CompilerParams *params);  /* uses params' allocator, including the optional hooks. */
 void context_destroy(Context *ctx);
 
+/* For reusable contexts (SDL_SHADER_Compiler), this preps for another run.
+   The previous run must have been cleaned up with the *_end() functions,
+   which leave reusable resources in place. Returns SDL_FALSE if out of memory. */
+SDL_bool context_reset(Context *ctx);
+
 /* This will only fail if the allocator fails, so it doesn't return any error code...NULL on failure. */
 SDL_bool preprocessor_start(Context *ctx, const SDL_SHADER_CompilerParams *params, SDL_bool asm_comments);
 
 void preprocessor_end(Context *ctx);  /* destroying the context will call this for you, too. Safe to call directly as well. */
 const char *preprocessor_nexttoken(Context *ctx, size_t *_len, Token *_token);
+Uint32 preprocessor_tokenhash(Context *ctx);  /* hash_string() of the last TOKEN_IDENTIFIER preprocessor_nexttoken() returned. */
 
 void ast_end(Context *ctx);
 void compiler_end(Context *ctx);
 
-Context *parse_to_ast(const SDL_SHADER_CompilerParams *params);
+/* if ctx is NULL, this creates a new context. Returns NULL if out of memory. */
+Context *parse_to_ast(Context *ctx, const SDL_SHADER_CompilerParams *params);
 
 
 /* Somehow there isn't an SDL_memchr ... */
 const void *MemChr(const void *buf, const Uint8 b, size_t buflen);
 
+/* A set of bytes for scan_bytes() to stop at, which always includes null.
+   `table` has BYTESCAN_STOP for each of them (that's what the portable scan
+   uses), and `bytes` lists them again for the SIMD kernels, with any unused
+   slots left null. If count_newlines is set, table['\n'] is BYTESCAN_NEWLINE
+   instead, and '\n' is counted but doesn't stop the scan. */
+#define BYTESCAN_STOP 1
+#define BYTESCAN_NEWLINE 2
+typedef struct ByteScan
+{
+    Uint8 table[256];
+    Uint8 bytes[8];
+    SDL_bool count_newlines;
+} ByteScan;
+
+/* Returns the first byte at or after `ptr` that's in `scan`, adding any
+   newlines it passes to *newlines if scan->count_newlines. One of them must
+   turn up before `end` (a source's null padding will do), since the portable
+   scan doesn't check, but the SIMD kernels never read past it. */
+const char *scan_bytes_simd(const char *ptr, const char *end, const ByteScan *scan, Sint32 *newlines);
+static inline const char *scan_bytes(const char *ptr, const char *end, const ByteScan *scan, Sint32 *newlines)
+{
+    /* most scans are short (a string literal, the rest of a line), so check
+       the first few bytes with the table before setting up a SIMD kernel. */
+    const Uint8 *table = scan->table;
+    const char *simd = ptr + 32;
+    while (ptr < simd) {
+        if (!table[(Uint8) ptr[0]] && !table[(Uint8) ptr[1]] && !table[(Uint8) ptr[2]] && !table[(Uint8) ptr[3]]) {
+            ptr += 4;
+        } else {
+            while (!table[(Uint8) *ptr]) {
+                ptr++;
+            }
+            if (table[(Uint8) *ptr] == BYTESCAN_STOP) {
+                return ptr;
+            }
+            (*newlines)++;
+            ptr++;
+        }
+    }
+    return scan_bytes_simd(ptr, end, scan, newlines);
+}
+
 /* Can't use SDL_strdup because we need to handle custom allocators and Context::out_of_memory */
 char *StrDup(Context *ctx, const char *str);
 
-/* Helpers for memory allocation inside a Context */
+/* Helpers for memory allocation inside a Context. These keep ctx->memstats up to date. */
 void *Malloc(Context *ctx, const size_t len);
+void *Realloc(Context *ctx, void *ptr, const size_t len);  /* like realloc(), but ptr stays valid on failure. */
 void Free(Context *ctx, void *ptr);
 
+/* Malloc() hides some bookkeeping in front of each allocation, so memory we
+   give to the app has to be freed with FreeReturnedData() once the Context is
+   gone, and not with the app's allocator directly. Disown() stops counting an
+   allocation against the Context without freeing it, for reusable contexts
+   that shouldn't keep charging themselves for data the app now owns. */
+void Disown(Context *ctx, const void *ptr);
+void FreeReturnedData(SDL_SHADER_Free f, void *d, const void *ptr);
+
 /* These are for things that need SDL_SHADER_Malloc/Free and want to use a Context's
    existing allocators. The "data" must be the Context pointer. */
 void *MallocContextBridge(size_t bytes, void *data);
+void *ReallocContextBridge(void *ptr, size_t oldbytes, size_t newbytes, void *data);
 void FreeContextBridge(void *ptr, void *data);
 
+size_t source_position_add_file(Context *ctx, const char *source, const size_t srclen);  /* source must be padded for the lexer, and live until source_position_close_file(). Returns the file's base position, 0 on failure. */
+void source_position_close_file(Context *ctx, const size_t base);  /* the source for `base` is going away. */
+Sint32 source_position_line(Context *ctx, const size_t position);  /* the physical line, ignoring #line. 0 if unknown. */
+Sint32 source_position_column(Context *ctx, const size_t position);  /* 0 if unknown. */
+size_t utf8_find_invalid(const char *str, const size_t len);  /* offset of the first bad UTF-8 sequence, or len if there aren't any. */
+void source_position_reset(Context *ctx);
+
 void fail(Context *ctx, const char *reason);
 void failf(Context *ctx, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(2);
 void warn(Context *ctx, const char *reason);
@@ -25,31 +25,56 @@ typedef unsigned char uchar;
 
 #define YYMAXFILL 8
 
-#define RET(t) return update_state(s, eoi, cursor, token, (Token) t)
+#define RET(t) return update_state(s, cursor, token, (Token) t)
 #define YYCTYPE uchar
 #define YYCURSOR cursor
-#define YYLIMIT limit
 #define YYMARKER s->lexer_marker
-#define YYFILL(n) { if ((n) == 1) { cursor = sentinel; limit = cursor + YYMAXFILL; eoi = 1; } }
 
-static uchar sentinel[YYMAXFILL];
+/* Every source is followed by LEXER_PADDING null bytes (see push_source()),
+   so the scanner can never run off the end of it, and re2c doesn't need to
+   check YYLIMIT before every character. The null at the end of the source is
+   told apart from a stray null inside it by where the cursor ends up. */
+SDL_COMPILE_TIME_ASSERT(lexer_padding, YYMAXFILL <= LEXER_PADDING);
 
-static Token update_state(IncludeState *s, int eoi, const uchar *cur, const uchar *tok, const Token val)
+/* Comments and string literals are mostly bytes that the re2c states below
+   just loop over one at a time, with a jump for each.
+   These skip straight to the next byte the state actually has to look at,
+   so long license headers and doc comments don't crawl through re2c.
+   scan_bytes() does this 16 or 32 bytes at a time when the CPU can. */
+static const ByteScan scan_multicomment = {  /* '*', '\r', null; counts '\n'. */
+    { ['\0'] = BYTESCAN_STOP, ['\r'] = BYTESCAN_STOP, ['*'] = BYTESCAN_STOP, ['\n'] = BYTESCAN_NEWLINE },
+    { '\0', '\r', '*' }, SDL_TRUE
+};
+
+static const ByteScan scan_singlecomment = {  /* newlines, null. */
+    { ['\0'] = BYTESCAN_STOP, ['\n'] = BYTESCAN_STOP, ['\r'] = BYTESCAN_STOP },
+    { '\0', '\n', '\r' }, SDL_FALSE
+};
+
+static const ByteScan scan_string = {  /* '"', null. */
+    { ['\0'] = BYTESCAN_STOP, ['"'] = BYTESCAN_STOP },
+    { '\0', '"' }, SDL_FALSE
+};
+
+/* every scan stops at null, so this stops at the end of the source, and
+   the SIMD kernels can read into its padding, but no further.
+   A lone '\n' in a comment can't be half of a "\r\n" (re2c would have eaten
+   both), so those are counted as we go, and '\r' is left to the re2c state. */
+static const uchar *scan_until(const uchar *cursor, const uchar *limit, const ByteScan *scan, Sint32 *line)
+{
+    return (const uchar *) scan_bytes((const char *) cursor, (const char *) (limit + LEXER_PADDING), scan, line);
+}
+
+static Token update_state(IncludeState *s, const uchar *cur, const uchar *tok, const Token val)
 {
-    if (eoi) {
-        s->bytes_left = 0;
-        s->source = (const char *) s->source_base + s->orig_length;
-        if ( (tok >= sentinel) && (tok < (sentinel+YYMAXFILL)) ) {
-            s->token = s->source;
-        } else {
-            s->token = (const char *) tok;
-        }
-    } else {
-        s->bytes_left -= (size_t) (cur - ((const uchar *) s->source));
-        s->source = (const char *) cur;
-        s->token = (const char *) tok;
+    const uchar *end = ((const uchar *) s->source) + s->bytes_left;
+    if (cur > end) {  /* we ate the null that terminates the source. */
+        cur = end;
     }
-    s->tokenlen = (size_t) (s->source - s->token);
+    s->bytes_left -= (size_t) (cur - ((const uchar *) s->source));
+    s->source = (const char *) cur;
+    s->token = (const char *) tok;
+    s->tokenlen = (size_t) (cur - tok);
     s->tokenval = val;
     return val;
 }
@@ -59,8 +84,7 @@ Token preprocessor_lexer(IncludeState *s)
     const uchar *cursor = (const uchar *) s->source;
     const uchar *token = cursor;
     const uchar *matchptr;
-    const uchar *limit = cursor + s->bytes_left;
-    int eoi = 0;
+    const uchar *limit = cursor + s->bytes_left;  /* the null that ends the source. */
 
 
 
@@ -77,14 +101,12 @@ Token preprocessor_lexer(IncludeState *s)
     }
 
 scanner_loop:
-    if (YYLIMIT <= YYCURSOR) { YYFILL(1); }
     token = cursor;
 
 
 {
 	YYCTYPE yych;
 	unsigned int yyaccept = 0;
-	if ((YYLIMIT - YYCURSOR) < 4) YYFILL(4);
 	yych = *YYCURSOR;
 	switch (yych) {
 		case 0x00: goto yy1;
@@ -190,14 +212,13 @@ scanner_loop:
 	}
 yy1:
 	++YYCURSOR;
-	{ if (eoi) { RET(TOKEN_EOI); } goto bad_chars; }
+	{ if (cursor > limit) { RET(TOKEN_EOI); } goto bad_chars; }
 yy2:
 	++YYCURSOR;
 yy3:
 	{ goto bad_chars; }
 yy4:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= '\n') {
 		if (yych == '\t') goto yy4;
@@ -294,7 +315,6 @@ yy24:
 yy25:
 	yyaccept = 1;
 	YYMARKER = ++YYCURSOR;
-	if ((YYLIMIT - YYCURSOR) < 3) YYFILL(3);
 	yych = *YYCURSOR;
 yy26:
 	if (yych <= 'L') {
@@ -354,7 +374,6 @@ yy35:
 	{ RET('@'); }
 yy36:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= 'Z') {
 		if (yych <= '/') goto yy37;
@@ -369,7 +388,12 @@ yy36:
 		}
 	}
 yy37:
-	{ RET(TOKEN_IDENTIFIER); }
+	{
+                        /* hash it now, so the define table and string caches don't have to. */
+                        update_state(s, cursor, token, TOKEN_IDENTIFIER);
+                        s->tokenhash = hash_string(s->token, s->tokenlen);
+                        return TOKEN_IDENTIFIER;
+                    }
 yy38:
 	++YYCURSOR;
 	{ RET('['); }
@@ -418,7 +442,6 @@ yy50:
 	{ RET(TOKEN_ANDASSIGN); }
 yy51:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 yy52:
 	if (yych <= '\r') {
@@ -453,7 +476,6 @@ yy54:
 	goto yy24;
 yy55:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= 'b') {
 		if (yych <= '7') {
@@ -514,7 +536,6 @@ yy60:
 yy61:
 	yyaccept = 2;
 	YYMARKER = ++YYCURSOR;
-	if ((YYLIMIT - YYCURSOR) < 3) YYFILL(3);
 	yych = *YYCURSOR;
 	if (yych <= 'G') {
 		if (yych <= 'D') {
@@ -557,7 +578,6 @@ yy66:
 	}
 yy67:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= 'U') {
 		if (yych == 'L') goto yy67;
@@ -603,7 +623,6 @@ yy73:
 	{ RET(TOKEN_RSHIFT); }
 yy74:
 	++YYCURSOR;
-	if ((YYLIMIT - YYCURSOR) < 2) YYFILL(2);
 	yych = *YYCURSOR;
 yy75:
 	if (yych <= '\f') {
@@ -633,7 +652,6 @@ yy81:
 	{ RET(TOKEN_OROR); }
 yy82:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= '@') {
 		if (yych <= '/') goto yy53;
@@ -654,7 +672,6 @@ yy84:
 	if (yych >= ':') goto yy53;
 yy85:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= 'G') {
 		if (yych <= '9') {
@@ -676,7 +693,6 @@ yy85:
 	}
 yy86:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= 'T') {
 		if (yych <= '@') {
@@ -712,11 +728,10 @@ yy88:
 stringliteral:
     /* !!! FIXME: forbid newlines in string literals? */
     /* !!! FIXME: the ANY section used to be `(ESC|ANY\[\r\n\\"])` ...is that redundant or was it like that for a reason? */
-    if (YYLIMIT <= YYCURSOR) { YYFILL(1); }
+    cursor = scan_until(cursor, limit, &scan_string, NULL);
 
 {
 	YYCTYPE yych;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= 0x00) goto yy90;
 	if (yych == '"') goto yy92;
@@ -724,7 +739,7 @@ stringliteral:
 yy90:
 	++YYCURSOR;
 	{
-                        if (eoi) {
+                        if (cursor > limit) {
                             RET(TOKEN_INCOMPLETE_STRING_LITERAL);
                         }
                         goto stringliteral;
@@ -739,13 +754,12 @@ yy92:
 
 
 multilinecomment:
-    if (YYLIMIT <= YYCURSOR) { YYFILL(1); }
+    cursor = scan_until(cursor, limit, &scan_multicomment, &s->line);
     matchptr = cursor;
 /* The "*\/" is just to avoid screwing up text editor syntax highlighting. */
 
 {
 	YYCTYPE yych;
-	if ((YYLIMIT - YYCURSOR) < 2) YYFILL(2);
 	yych = *YYCURSOR;
 	if (yych <= '\f') {
 		if (yych <= 0x00) goto yy94;
@@ -759,7 +773,7 @@ multilinecomment:
 yy94:
 	++YYCURSOR;
 	{
-                        if (eoi) {
+                        if (cursor > limit) {
                             RET(TOKEN_INCOMPLETE_COMMENT);
                         }
                         goto multilinecomment;
@@ -788,12 +802,11 @@ yy100:
 
 
 singlelinecomment:
-    if (YYLIMIT <= YYCURSOR) { YYFILL(1); }
+    cursor = scan_until(cursor, limit, &scan_singlecomment, NULL);
     matchptr = cursor;
 
 {
 	YYCTYPE yych;
-	if ((YYLIMIT - YYCURSOR) < 2) YYFILL(2);
 	yych = *YYCURSOR;
 	if (yych <= '\n') {
 		if (yych <= 0x00) goto yy102;
@@ -827,12 +840,10 @@ yy106:
 
 
 ppdirective:
-    if (YYLIMIT <= YYCURSOR) { YYFILL(1); }
 
 {
 	YYCTYPE yych;
 	unsigned int yyaccept = 0;
-	if ((YYLIMIT - YYCURSOR) < 8) YYFILL(8);
 	yych = *YYCURSOR;
 	if (yych <= '\f') {
 		if (yych <= 0x08) {
@@ -867,7 +878,6 @@ yy110:
                         }
 yy111:
 	++YYCURSOR;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= '\n') {
 		if (yych == '\t') goto yy111;
@@ -902,7 +912,6 @@ yy112:
 	}
 yy113:
 	++YYCURSOR;
-	if ((YYLIMIT - YYCURSOR) < 7) YYFILL(7);
 	yych = *YYCURSOR;
 yy114:
 	if (yych <= 'h') {
@@ -1131,11 +1140,9 @@ yy165:
 
 
 bad_chars:
-    if (YYLIMIT <= YYCURSOR) { YYFILL(1); }
 
 {
 	YYCTYPE yych;
-	if (YYLIMIT <= YYCURSOR) YYFILL(1);
 	yych = *YYCURSOR;
 	if (yych <= '#') {
 		if (yych <= '\r') {
@@ -1161,11 +1168,8 @@ bad_chars:
 yy167:
 	++YYCURSOR;
 	{
-                        if (eoi)
-                        {
-                            SDL_assert( !((token >= sentinel) && (token < sentinel+YYMAXFILL)) );
-                            eoi = 0;
-                            cursor = (uchar *) s->source_base + s->orig_length;
+                        if (cursor > limit) {
+                            cursor = limit;
                             RET(TOKEN_BAD_CHARS);  // next call will be EOI.
                         }
                         goto bad_chars;
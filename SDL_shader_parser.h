@@ -1025,153 +1025,41 @@ static void yy_destructor(
     ** inside the C code.
     */
 /********* Begin destructor definitions ***************************************/
+      /* Default NON-TERMINAL Destructor */
     case 68: /* shader */
-{
-#line 62 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_shader(ctx, (yypminor->yy94)); 
-#line 1033 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 69: /* translation_unit_list */
-{
-#line 66 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_translation_units(ctx, (yypminor->yy33)); 
-#line 1040 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 70: /* translation_unit */
-{
-#line 73 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_translation_unit(ctx, (yypminor->yy142)); 
-#line 1047 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 71: /* struct_declaration */
-{
-#line 85 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_struct_declaration(ctx, (yypminor->yy6)); 
-#line 1054 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 72: /* function */
-{
-#line 105 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_function(ctx, (yypminor->yy81)); 
-#line 1061 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 73: /* at_attrib */
-{
-#line 80 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_at_attribute(ctx, (yypminor->yy44)); 
-#line 1068 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 74: /* struct_member_list */
-{
-#line 89 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_struct_members(ctx, (yypminor->yy95)); 
-#line 1075 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 75: /* struct_member */
-{
-#line 98 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_struct_member(ctx, (yypminor->yy120)); 
-#line 1082 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 76: /* expression */
-{
-#line 263 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_expression(ctx, (yypminor->yy167)); 
-#line 1089 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 77: /* return_type */
-{
-#line 110 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-
-#line 1096 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 78: /* function_params */
-    case 80: /* function_param_list */
-{
-#line 115 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_function_params(ctx, (yypminor->yy137)); 
-#line 1104 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 79: /* statement_block */
-    case 82: /* statement_list */
-{
-#line 134 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_statement_block(ctx, (yypminor->yy3)); 
-#line 1112 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
+    case 80: /* function_param_list */
     case 81: /* function_param */
-{
-#line 129 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_function_param(ctx, (yypminor->yy178)); 
-#line 1119 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
+    case 82: /* statement_list */
     case 83: /* statement */
+    case 84: /* var_declaration */
+    case 85: /* for_details */
+    case 86: /* switch_case_list */
     case 87: /* assignment_statement */
     case 88: /* compound_assignment_statement */
     case 89: /* increment_statement */
     case 90: /* function_call_statement */
-    case 94: /* for_initializer */
-    case 95: /* for_step */
-{
-#line 144 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_statement(ctx, (yypminor->yy36)); 
-#line 1132 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
-    case 84: /* var_declaration */
-{
-#line 246 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_var_declaration(ctx, (yypminor->yy50)); 
-#line 1139 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
-    case 85: /* for_details */
-{
-#line 209 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_for_details(ctx, (yypminor->yy184)); 
-#line 1146 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
-    case 86: /* switch_case_list */
-{
-#line 229 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_switch_cases(ctx, (yypminor->yy64)); 
-#line 1153 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
     case 91: /* assignment_statement_list */
-{
-#line 174 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_assignments(ctx, (yypminor->yy63)); 
-#line 1160 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
+    case 92: /* compound_assignment_operator */
     case 93: /* arguments */
-    case 97: /* argument_list */
-{
-#line 252 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_arguments(ctx, (yypminor->yy93)); 
-#line 1168 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
-}
-      break;
+    case 94: /* for_initializer */
+    case 95: /* for_step */
     case 96: /* switch_case */
+    case 97: /* argument_list */
 {
-#line 236 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
- delete_switch_case(ctx, (yypminor->yy97)); 
-#line 1175 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 37 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+ (void) ctx; 
+#line 1063 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
 }
       break;
 /********* End destructor definitions *****************************************/
@@ -1407,7 +1295,7 @@ static void yyStackOverflow(yyParser *yypParser){
 
     // !!! FIXME: make this a proper fail() function.
     fail(ctx, "Giving up. Parser stack overflow");
-#line 1411 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1299 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
 /******** End %stack_overflow code ********************************************/
    ParseSDLSLARG_STORE /* Suppress warning about unused %extra_argument var */
    ParseSDLSLCTX_STORE
@@ -1768,366 +1656,386 @@ static YYACTIONTYPE yy_reduce(
 /********** Begin reduce actions **********************************************/
         YYMINORTYPE yylhsminor;
       case 0: /* shader ::= translation_unit_list */
-#line 63 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ SDL_assert(!ctx->shader); ctx->shader = new_shader(ctx, yymsp[0].minor.yy33); }
-#line 1774 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 66 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ SDL_assert(!ctx->shader); ctx->shader = new_shader(ctx, node_location(yymsp[0].minor.yy33 ? yymsp[0].minor.yy33->head : NULL), yymsp[0].minor.yy33); }
+#line 1662 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 1: /* translation_unit_list ::= translation_unit */
-#line 67 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 69 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy33 = new_translation_units(ctx, yymsp[0].minor.yy142); }
-#line 1779 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1667 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy33 = yylhsminor.yy33;
         break;
       case 2: /* translation_unit_list ::= translation_unit_list translation_unit */
-#line 68 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 70 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-1].minor.yy33->tail->next = yymsp[0].minor.yy142; yymsp[-1].minor.yy33->tail = yymsp[0].minor.yy142; yylhsminor.yy33 = yymsp[-1].minor.yy33; }
-#line 1785 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1673 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy33 = yylhsminor.yy33;
         break;
       case 3: /* translation_unit ::= struct_declaration */
-#line 74 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy142 = new_struct_declaration_unit(ctx, yymsp[0].minor.yy6); }
-#line 1791 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 75 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy142 = new_struct_declaration_unit(ctx, node_location(yymsp[0].minor.yy6), yymsp[0].minor.yy6); }
+#line 1679 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy142 = yylhsminor.yy142;
         break;
       case 4: /* translation_unit ::= function */
-#line 75 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy142 = new_function_unit(ctx, yymsp[0].minor.yy81); }
-#line 1797 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 76 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy142 = new_function_unit(ctx, node_location(yymsp[0].minor.yy81), yymsp[0].minor.yy81); }
+#line 1685 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy142 = yylhsminor.yy142;
         break;
       case 5: /* at_attrib ::= AT IDENTIFIER */
 #line 81 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy44 = new_at_attribute(ctx, yymsp[0].minor.yy0.string, NULL); }
-#line 1803 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+{ yylhsminor.yy44 = new_at_attribute(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy0.value.string, NULL); }
+#line 1691 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy44 = yylhsminor.yy44;
         break;
       case 6: /* at_attrib ::= AT IDENTIFIER LPAREN INT_CONSTANT RPAREN */
 #line 82 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-4].minor.yy44 = new_at_attribute(ctx, yymsp[-3].minor.yy0.string, &yymsp[-1].minor.yy0.i64); }
-#line 1808 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+{ yylhsminor.yy44 = new_at_attribute(ctx, yymsp[-4].minor.yy0.where, yymsp[-3].minor.yy0.value.string, &yymsp[-1].minor.yy0.value.i64); }
+#line 1697 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-4].minor.yy44 = yylhsminor.yy44;
         break;
       case 7: /* struct_declaration ::= STRUCT IDENTIFIER LBRACE struct_member_list RBRACE SEMICOLON */
-#line 86 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-5].minor.yy6 = new_struct_declaration(ctx, yymsp[-4].minor.yy0.string, yymsp[-2].minor.yy95); }
-#line 1813 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 85 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy6 = new_struct_declaration(ctx, yymsp[-5].minor.yy0.where, yymsp[-4].minor.yy0.value.string, yymsp[-2].minor.yy95); }
+#line 1703 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-5].minor.yy6 = yylhsminor.yy6;
         break;
       case 8: /* struct_member_list ::= struct_member */
-#line 90 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 88 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy95 = new_struct_members(ctx, yymsp[0].minor.yy120); }
-#line 1818 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1709 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy95 = yylhsminor.yy95;
         break;
       case 9: /* struct_member_list ::= struct_member_list struct_member */
-#line 91 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 89 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-1].minor.yy95->tail->next = yymsp[0].minor.yy120; yymsp[-1].minor.yy95->tail = yymsp[0].minor.yy120; yylhsminor.yy95 = yymsp[-1].minor.yy95; }
-#line 1824 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1715 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy95 = yylhsminor.yy95;
         break;
       case 10: /* struct_member ::= IDENTIFIER IDENTIFIER SEMICOLON */
-#line 99 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-2].minor.yy0.string, yymsp[-1].minor.yy0.string, NULL, NULL); }
-#line 1830 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 96 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-2].minor.yy0.where, yymsp[-2].minor.yy0.value.string, yymsp[-1].minor.yy0.value.string, NULL, NULL); }
+#line 1721 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy120 = yylhsminor.yy120;
         break;
       case 11: /* struct_member ::= IDENTIFIER IDENTIFIER at_attrib SEMICOLON */
-#line 100 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-3].minor.yy0.string, yymsp[-2].minor.yy0.string, NULL, yymsp[-1].minor.yy44); }
-#line 1836 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 97 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-3].minor.yy0.where, yymsp[-3].minor.yy0.value.string, yymsp[-2].minor.yy0.value.string, NULL, yymsp[-1].minor.yy44); }
+#line 1727 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-3].minor.yy120 = yylhsminor.yy120;
         break;
       case 12: /* struct_member ::= IDENTIFIER IDENTIFIER LBRACKET expression RBRACKET SEMICOLON */
-#line 101 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-5].minor.yy0.string, yymsp[-4].minor.yy0.string, yymsp[-2].minor.yy167, NULL); }
-#line 1842 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 98 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-5].minor.yy0.where, yymsp[-5].minor.yy0.value.string, yymsp[-4].minor.yy0.value.string, yymsp[-2].minor.yy167, NULL); }
+#line 1733 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-5].minor.yy120 = yylhsminor.yy120;
         break;
       case 13: /* struct_member ::= IDENTIFIER IDENTIFIER LBRACKET expression RBRACKET at_attrib SEMICOLON */
-#line 102 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-6].minor.yy0.string, yymsp[-5].minor.yy0.string, yymsp[-3].minor.yy167, yymsp[-1].minor.yy44); }
-#line 1848 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 99 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy120 = new_struct_member(ctx, yymsp[-6].minor.yy0.where, yymsp[-6].minor.yy0.value.string, yymsp[-5].minor.yy0.value.string, yymsp[-3].minor.yy167, yymsp[-1].minor.yy44); }
+#line 1739 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-6].minor.yy120 = yylhsminor.yy120;
         break;
       case 14: /* function ::= FUNCTION return_type IDENTIFIER function_params statement_block */
-#line 106 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-4].minor.yy81 = new_function(ctx, yymsp[-3].minor.yy168, yymsp[-2].minor.yy0.string, yymsp[-1].minor.yy137, NULL, yymsp[0].minor.yy3); }
-#line 1854 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 102 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy81 = new_function(ctx, yymsp[-4].minor.yy0.where, yymsp[-3].minor.yy168, yymsp[-2].minor.yy0.value.string, yymsp[-1].minor.yy137, NULL, yymsp[0].minor.yy3); }
+#line 1745 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-4].minor.yy81 = yylhsminor.yy81;
         break;
       case 15: /* function ::= FUNCTION return_type IDENTIFIER function_params at_attrib statement_block */
-#line 107 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-5].minor.yy81 = new_function(ctx, yymsp[-4].minor.yy168, yymsp[-3].minor.yy0.string, yymsp[-2].minor.yy137, yymsp[-1].minor.yy44, yymsp[0].minor.yy3); }
-#line 1859 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 103 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy81 = new_function(ctx, yymsp[-5].minor.yy0.where, yymsp[-4].minor.yy168, yymsp[-3].minor.yy0.value.string, yymsp[-2].minor.yy137, yymsp[-1].minor.yy44, yymsp[0].minor.yy3); }
+#line 1751 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-5].minor.yy81 = yylhsminor.yy81;
         break;
       case 16: /* return_type ::= VOID */
-#line 111 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 106 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy168 = NULL; }
-#line 1864 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1757 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 17: /* return_type ::= IDENTIFIER */
-#line 112 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy168 = yymsp[0].minor.yy0.string; }
-#line 1869 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 107 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy168 = yymsp[0].minor.yy0.value.string; }
+#line 1762 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy168 = yylhsminor.yy168;
         break;
       case 18: /* function_params ::= LPAREN RPAREN */
-#line 116 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 110 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-1].minor.yy137 = NULL; }
-#line 1875 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1768 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 19: /* function_params ::= LPAREN VOID RPAREN */
-#line 117 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 111 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy137 = NULL; }
-#line 1880 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1773 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 20: /* function_params ::= LPAREN function_param_list RPAREN */
-#line 118 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 112 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy137 = yymsp[-1].minor.yy137; }
-#line 1885 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1778 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 21: /* function_param_list ::= function_param */
-#line 122 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 115 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy137 = new_function_params(ctx, yymsp[0].minor.yy178); }
-#line 1890 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1783 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy137 = yylhsminor.yy137;
         break;
       case 22: /* function_param_list ::= function_param_list COMMA function_param */
-#line 123 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 116 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy137->tail->next = yymsp[0].minor.yy178; yymsp[-2].minor.yy137->tail = yymsp[0].minor.yy178; yylhsminor.yy137 = yymsp[-2].minor.yy137; }
-#line 1896 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1789 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy137 = yylhsminor.yy137;
         break;
       case 23: /* function_param ::= IDENTIFIER IDENTIFIER */
-#line 130 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy178 = new_function_param(ctx, yymsp[-1].minor.yy0.string, yymsp[0].minor.yy0.string, NULL); }
-#line 1902 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 122 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy178 = new_function_param(ctx, yymsp[-1].minor.yy0.where, yymsp[-1].minor.yy0.value.string, yymsp[0].minor.yy0.value.string, NULL); }
+#line 1795 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy178 = yylhsminor.yy178;
         break;
       case 24: /* function_param ::= IDENTIFIER IDENTIFIER at_attrib */
-#line 131 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy178 = new_function_param(ctx, yymsp[-2].minor.yy0.string, yymsp[-1].minor.yy0.string, yymsp[0].minor.yy44); }
-#line 1908 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 123 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy178 = new_function_param(ctx, yymsp[-2].minor.yy0.where, yymsp[-2].minor.yy0.value.string, yymsp[-1].minor.yy0.value.string, yymsp[0].minor.yy44); }
+#line 1801 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy178 = yylhsminor.yy178;
         break;
       case 25: /* statement_block ::= LBRACE RBRACE */
-#line 135 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy3 = new_statement_block(ctx, NULL); }
-#line 1914 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 126 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy3 = new_statement_block(ctx, yymsp[-1].minor.yy0.where, NULL); }
+#line 1807 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy3 = yylhsminor.yy3;
         break;
       case 26: /* statement_block ::= LBRACE statement_list RBRACE */
-#line 136 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 127 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy3 = yymsp[-1].minor.yy3; }
-#line 1919 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1813 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 27: /* statement_list ::= statement */
-#line 140 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy3 = new_statement_block(ctx, yymsp[0].minor.yy36); }
-#line 1924 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 130 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy3 = new_statement_block(ctx, node_location(yymsp[0].minor.yy36), yymsp[0].minor.yy36); }
+#line 1818 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy3 = yylhsminor.yy3;
         break;
       case 28: /* statement_list ::= statement_list statement */
-#line 141 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 131 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-1].minor.yy3->tail->next = yymsp[0].minor.yy36; yymsp[-1].minor.yy3->tail = yymsp[0].minor.yy36; yylhsminor.yy3 = yymsp[-1].minor.yy3; }
-#line 1930 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1824 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy3 = yylhsminor.yy3;
         break;
       case 29: /* statement ::= SEMICOLON */
-#line 145 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[0].minor.yy36 = new_empty_statement(ctx); }
-#line 1936 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 134 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_empty_statement(ctx, yymsp[0].minor.yy0.where); }
+#line 1830 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[0].minor.yy36 = yylhsminor.yy36;
         break;
       case 30: /* statement ::= BREAK SEMICOLON */
-#line 146 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy36 = new_break_statement(ctx); }
-#line 1941 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 135 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_break_statement(ctx, yymsp[-1].minor.yy0.where); }
+#line 1836 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 31: /* statement ::= CONTINUE SEMICOLON */
-#line 147 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy36 = new_continue_statement(ctx); }
-#line 1946 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 136 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_continue_statement(ctx, yymsp[-1].minor.yy0.where); }
+#line 1842 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 32: /* statement ::= DISCARD SEMICOLON */
-#line 148 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy36 = new_discard_statement(ctx); }
-#line 1951 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 137 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_discard_statement(ctx, yymsp[-1].minor.yy0.where); }
+#line 1848 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 33: /* statement ::= var_declaration SEMICOLON */
-#line 149 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_var_declaration_statement(ctx, yymsp[-1].minor.yy50); }
-#line 1956 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 138 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_var_declaration_statement(ctx, node_location(yymsp[-1].minor.yy50), yymsp[-1].minor.yy50); }
+#line 1854 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 34: /* statement ::= DO statement WHILE LPAREN expression RPAREN SEMICOLON */
-#line 150 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-6].minor.yy36 = new_do_statement(ctx, yymsp[-5].minor.yy36, yymsp[-2].minor.yy167); }
-#line 1962 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 139 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_do_statement(ctx, yymsp[-6].minor.yy0.where, yymsp[-5].minor.yy36, yymsp[-2].minor.yy167); }
+#line 1860 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-6].minor.yy36 = yylhsminor.yy36;
         break;
       case 35: /* statement ::= WHILE LPAREN expression RPAREN statement */
-#line 151 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-4].minor.yy36 = new_while_statement(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy36); }
-#line 1967 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 140 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_while_statement(ctx, yymsp[-4].minor.yy0.where, yymsp[-2].minor.yy167, yymsp[0].minor.yy36); }
+#line 1866 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-4].minor.yy36 = yylhsminor.yy36;
         break;
       case 36: /* statement ::= FOR LPAREN for_details RPAREN statement */
-#line 152 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-4].minor.yy36 = new_for_statement(ctx, yymsp[-2].minor.yy184, yymsp[0].minor.yy36); }
-#line 1972 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 141 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_for_statement(ctx, yymsp[-4].minor.yy0.where, yymsp[-2].minor.yy184, yymsp[0].minor.yy36); }
+#line 1872 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-4].minor.yy36 = yylhsminor.yy36;
         break;
       case 37: /* statement ::= IF LPAREN expression RPAREN statement */
-#line 153 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-4].minor.yy36 = new_if_statement(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy36, NULL); }
-#line 1977 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 142 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_if_statement(ctx, yymsp[-4].minor.yy0.where, yymsp[-2].minor.yy167, yymsp[0].minor.yy36, NULL); }
+#line 1878 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-4].minor.yy36 = yylhsminor.yy36;
         break;
       case 38: /* statement ::= IF LPAREN expression RPAREN statement ELSE statement */
-#line 154 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-6].minor.yy36 = new_if_statement(ctx, yymsp[-4].minor.yy167, yymsp[-2].minor.yy36, yymsp[0].minor.yy36); }
-#line 1982 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 143 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_if_statement(ctx, yymsp[-6].minor.yy0.where, yymsp[-4].minor.yy167, yymsp[-2].minor.yy36, yymsp[0].minor.yy36); }
+#line 1884 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-6].minor.yy36 = yylhsminor.yy36;
         break;
       case 39: /* statement ::= SWITCH LPAREN expression RPAREN LBRACE switch_case_list RBRACE */
-#line 155 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-6].minor.yy36 = new_switch_statement(ctx, yymsp[-4].minor.yy167, yymsp[-1].minor.yy64); }
-#line 1987 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 144 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_switch_statement(ctx, yymsp[-6].minor.yy0.where, yymsp[-4].minor.yy167, yymsp[-1].minor.yy64); }
+#line 1890 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-6].minor.yy36 = yylhsminor.yy36;
         break;
       case 40: /* statement ::= RETURN SEMICOLON */
-#line 157 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy36 = new_return_statement(ctx, NULL); }
-#line 1992 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 146 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_return_statement(ctx, yymsp[-1].minor.yy0.where, NULL); }
+#line 1896 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 41: /* statement ::= RETURN expression SEMICOLON */
-#line 158 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-2].minor.yy36 = new_return_statement(ctx, yymsp[-1].minor.yy167); }
-#line 1997 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 147 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_return_statement(ctx, yymsp[-2].minor.yy0.where, yymsp[-1].minor.yy167); }
+#line 1902 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-2].minor.yy36 = yylhsminor.yy36;
         break;
       case 42: /* statement ::= assignment_statement SEMICOLON */
       case 43: /* statement ::= compound_assignment_statement SEMICOLON */ yytestcase(yyruleno==43);
       case 44: /* statement ::= increment_statement SEMICOLON */ yytestcase(yyruleno==44);
       case 45: /* statement ::= function_call_statement SEMICOLON */ yytestcase(yyruleno==45);
-#line 159 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 148 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy36 = yymsp[-1].minor.yy36; }
-#line 2005 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1911 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 46: /* statement ::= statement_block */
-#line 163 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 152 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy36 = (SDL_SHADER_AstStatement *) yymsp[0].minor.yy3; }
-#line 2011 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1917 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy36 = yylhsminor.yy36;
         break;
       case 47: /* assignment_statement ::= assignment_statement_list expression */
-#line 171 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_assignment_statement(ctx, yymsp[-1].minor.yy63, yymsp[0].minor.yy167); }
-#line 2017 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 159 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_assignment_statement(ctx, node_location((yymsp[-1].minor.yy63 && yymsp[-1].minor.yy63->head) ? yymsp[-1].minor.yy63->head->expr : NULL), yymsp[-1].minor.yy63, yymsp[0].minor.yy167); }
+#line 1923 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 48: /* assignment_statement_list ::= expression ASSIGN */
-#line 175 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 162 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy63 = new_assignments(ctx, new_assignment(ctx, yymsp[-1].minor.yy167)); }
-#line 2023 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1929 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy63 = yylhsminor.yy63;
         break;
       case 49: /* assignment_statement_list ::= assignment_statement_list expression ASSIGN */
-#line 176 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 163 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy63->tail->next = new_assignment(ctx, yymsp[-1].minor.yy167); yymsp[-2].minor.yy63->tail = yymsp[-2].minor.yy63->tail->next; yylhsminor.yy63 = yymsp[-2].minor.yy63; }
-#line 2029 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1935 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy63 = yylhsminor.yy63;
         break;
       case 50: /* compound_assignment_statement ::= expression compound_assignment_operator expression */
-#line 181 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_compound_assignment_statement(ctx, yymsp[-2].minor.yy167, yymsp[-1].minor.yy65, yymsp[0].minor.yy167); }
-#line 2035 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 167 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_compound_assignment_statement(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[-1].minor.yy65, yymsp[0].minor.yy167); }
+#line 1941 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy36 = yylhsminor.yy36;
         break;
       case 51: /* compound_assignment_operator ::= PLUSASSIGN */
-#line 184 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 170 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNADD; }
-#line 2041 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1947 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 52: /* compound_assignment_operator ::= MINUSASSIGN */
-#line 185 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 171 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNSUB; }
-#line 2046 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1952 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 53: /* compound_assignment_operator ::= STARASSIGN */
-#line 186 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 172 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNMUL; }
-#line 2051 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1957 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 54: /* compound_assignment_operator ::= SLASHASSIGN */
-#line 187 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 173 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNDIV; }
-#line 2056 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1962 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 55: /* compound_assignment_operator ::= PERCENTASSIGN */
-#line 188 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 174 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNMOD; }
-#line 2061 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1967 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 56: /* compound_assignment_operator ::= LSHIFTASSIGN */
-#line 189 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 175 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNLSHIFT; }
-#line 2066 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1972 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 57: /* compound_assignment_operator ::= RSHIFTASSIGN */
-#line 190 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 176 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNRSHIFT; }
-#line 2071 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1977 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 58: /* compound_assignment_operator ::= ANDASSIGN */
-#line 191 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 177 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNAND; }
-#line 2076 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1982 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 59: /* compound_assignment_operator ::= ORASSIGN */
-#line 192 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 178 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNOR; }
-#line 2081 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1987 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 60: /* compound_assignment_operator ::= XORASSIGN */
-#line 193 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 179 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[0].minor.yy65 = SDL_SHADER_AST_STATEMENT_COMPOUNDASSIGNXOR; }
-#line 2086 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 1992 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 61: /* increment_statement ::= PLUSPLUS expression */
-#line 198 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy36 = new_preincrement_statement(ctx, yymsp[0].minor.yy167); }
-#line 2091 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 183 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_preincrement_statement(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy167); }
+#line 1997 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 62: /* increment_statement ::= MINUSMINUS expression */
-#line 199 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy36 = new_predecrement_statement(ctx, yymsp[0].minor.yy167); }
-#line 2096 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 184 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_predecrement_statement(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy167); }
+#line 2003 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 63: /* increment_statement ::= expression PLUSPLUS */
-#line 200 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_postincrement_statement(ctx, yymsp[-1].minor.yy167); }
-#line 2101 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 185 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_postincrement_statement(ctx, node_location(yymsp[-1].minor.yy167), yymsp[-1].minor.yy167); }
+#line 2009 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 64: /* increment_statement ::= expression MINUSMINUS */
-#line 201 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_postdecrement_statement(ctx, yymsp[-1].minor.yy167); }
-#line 2107 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 186 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_postdecrement_statement(ctx, node_location(yymsp[-1].minor.yy167), yymsp[-1].minor.yy167); }
+#line 2015 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 65: /* function_call_statement ::= IDENTIFIER arguments */
-#line 206 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_fncall_statement(ctx, yymsp[-1].minor.yy0.string, yymsp[0].minor.yy93); }
-#line 2113 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 190 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_fncall_statement(ctx, yymsp[-1].minor.yy0.where, yymsp[-1].minor.yy0.value.string, yymsp[0].minor.yy93); }
+#line 2021 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy36 = yylhsminor.yy36;
         break;
       case 66: /* for_details ::= for_initializer SEMICOLON expression SEMICOLON for_step */
-#line 210 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 193 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy184 = new_for_details(ctx, yymsp[-4].minor.yy36, yymsp[-2].minor.yy167, yymsp[0].minor.yy36); }
-#line 2119 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2027 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-4].minor.yy184 = yylhsminor.yy184;
         break;
       case 67: /* for_details ::= for_initializer SEMICOLON SEMICOLON for_step */
-#line 211 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 194 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy184 = new_for_details(ctx, yymsp[-3].minor.yy36, NULL, yymsp[0].minor.yy36); }
-#line 2125 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2033 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-3].minor.yy184 = yylhsminor.yy184;
         break;
       case 68: /* for_initializer ::= var_declaration */
-#line 215 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy36 = new_var_declaration_statement(ctx, yymsp[0].minor.yy50); }
-#line 2131 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 197 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy36 = new_var_declaration_statement(ctx, node_location(yymsp[0].minor.yy50), yymsp[0].minor.yy50); }
+#line 2039 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy36 = yylhsminor.yy36;
         break;
       case 69: /* for_initializer ::= assignment_statement */
@@ -2136,264 +2044,277 @@ static YYACTIONTYPE yy_reduce(
       case 73: /* for_step ::= assignment_statement */ yytestcase(yyruleno==73);
       case 74: /* for_step ::= compound_assignment_statement */ yytestcase(yyruleno==74);
       case 75: /* for_step ::= increment_statement */ yytestcase(yyruleno==75);
-#line 216 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 198 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy36 = yymsp[0].minor.yy36; }
-#line 2142 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2050 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy36 = yylhsminor.yy36;
         break;
       case 72: /* for_initializer ::= */
       case 76: /* for_step ::= */ yytestcase(yyruleno==76);
-#line 219 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 201 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[1].minor.yy36 = NULL; }
-#line 2149 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2057 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 77: /* switch_case_list ::= switch_case */
-#line 230 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 210 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy64 = new_switch_cases(ctx, yymsp[0].minor.yy97); }
-#line 2154 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2062 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy64 = yylhsminor.yy64;
         break;
       case 78: /* switch_case_list ::= switch_case_list switch_case */
-#line 231 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 211 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-1].minor.yy64->tail->next = yymsp[0].minor.yy97; yymsp[-1].minor.yy64->tail = yymsp[0].minor.yy97; yylhsminor.yy64 = yymsp[-1].minor.yy64; }
-#line 2160 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2068 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy64 = yylhsminor.yy64;
         break;
       case 79: /* switch_case ::= CASE expression COLON statement */
-#line 237 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-3].minor.yy97 = new_switch_case(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy36); }
-#line 2166 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 216 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy97 = new_switch_case(ctx, yymsp[-3].minor.yy0.where, yymsp[-2].minor.yy167, yymsp[0].minor.yy36); }
+#line 2074 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-3].minor.yy97 = yylhsminor.yy97;
         break;
       case 80: /* switch_case ::= CASE expression COLON */
-#line 238 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-2].minor.yy97 = new_switch_case(ctx, yymsp[-1].minor.yy167, NULL); }
-#line 2171 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 217 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy97 = new_switch_case(ctx, yymsp[-2].minor.yy0.where, yymsp[-1].minor.yy167, NULL); }
+#line 2080 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-2].minor.yy97 = yylhsminor.yy97;
         break;
       case 81: /* switch_case ::= DEFAULT COLON statement */
-#line 239 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-2].minor.yy97 = new_switch_case(ctx, NULL, yymsp[0].minor.yy36); }
-#line 2176 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 218 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy97 = new_switch_case(ctx, yymsp[-2].minor.yy0.where, NULL, yymsp[0].minor.yy36); }
+#line 2086 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-2].minor.yy97 = yylhsminor.yy97;
         break;
       case 82: /* switch_case ::= DEFAULT COLON */
-#line 240 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy97 = new_switch_case(ctx, NULL, NULL); }
-#line 2181 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 219 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy97 = new_switch_case(ctx, yymsp[-1].minor.yy0.where, NULL, NULL); }
+#line 2092 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy97 = yylhsminor.yy97;
         break;
       case 83: /* var_declaration ::= VAR IDENTIFIER IDENTIFIER */
-#line 248 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-2].minor.yy50 = new_var_declaration(ctx, yymsp[-1].minor.yy0.string, yymsp[0].minor.yy0.string, NULL); }
-#line 2186 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 226 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy50 = new_var_declaration(ctx, yymsp[-2].minor.yy0.where, yymsp[-1].minor.yy0.value.string, yymsp[0].minor.yy0.value.string, NULL); }
+#line 2098 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-2].minor.yy50 = yylhsminor.yy50;
         break;
       case 84: /* var_declaration ::= VAR IDENTIFIER IDENTIFIER ASSIGN expression */
-#line 249 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-4].minor.yy50 = new_var_declaration(ctx, yymsp[-3].minor.yy0.string, yymsp[-2].minor.yy0.string, yymsp[0].minor.yy167); }
-#line 2191 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 227 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy50 = new_var_declaration(ctx, yymsp[-4].minor.yy0.where, yymsp[-3].minor.yy0.value.string, yymsp[-2].minor.yy0.value.string, yymsp[0].minor.yy167); }
+#line 2104 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-4].minor.yy50 = yylhsminor.yy50;
         break;
       case 85: /* arguments ::= LPAREN RPAREN */
-#line 253 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 230 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-1].minor.yy93 = NULL; }
-#line 2196 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2110 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 86: /* arguments ::= LPAREN argument_list RPAREN */
-#line 254 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 231 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy93 = yymsp[-1].minor.yy93; }
-#line 2201 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2115 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
         break;
       case 87: /* argument_list ::= expression */
-#line 258 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 234 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yylhsminor.yy93 = new_arguments(ctx, new_argument(ctx, yymsp[0].minor.yy167)); }
-#line 2206 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2120 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy93 = yylhsminor.yy93;
         break;
       case 88: /* argument_list ::= argument_list COMMA expression */
-#line 259 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+#line 235 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
 { yymsp[-2].minor.yy93->tail->next = new_argument(ctx, yymsp[0].minor.yy167); yymsp[-2].minor.yy93->tail = yymsp[-2].minor.yy93->tail->next; yylhsminor.yy93 = yymsp[-2].minor.yy93; }
-#line 2212 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2126 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy93 = yylhsminor.yy93;
         break;
       case 89: /* expression ::= IDENTIFIER */
-#line 264 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_identifier_expression(ctx, yymsp[0].minor.yy0.string); }
-#line 2218 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 239 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_identifier_expression(ctx, yymsp[0].minor.yy0.where, yymsp[0].minor.yy0.value.string); }
+#line 2132 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy167 = yylhsminor.yy167;
         break;
       case 90: /* expression ::= INT_CONSTANT */
-#line 265 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_int_expression(ctx, yymsp[0].minor.yy0.i64); }
-#line 2224 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 240 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_int_expression(ctx, yymsp[0].minor.yy0.where, yymsp[0].minor.yy0.value.i64); }
+#line 2138 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy167 = yylhsminor.yy167;
         break;
       case 91: /* expression ::= FLOAT_CONSTANT */
-#line 266 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_float_expression(ctx, yymsp[0].minor.yy0.dbl); }
-#line 2230 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 241 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_float_expression(ctx, yymsp[0].minor.yy0.where, yymsp[0].minor.yy0.value.dbl); }
+#line 2144 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[0].minor.yy167 = yylhsminor.yy167;
         break;
       case 92: /* expression ::= TRUE */
-#line 267 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[0].minor.yy167 = new_bool_expression(ctx, 1); }
-#line 2236 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 242 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_bool_expression(ctx, yymsp[0].minor.yy0.where, 1); }
+#line 2150 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[0].minor.yy167 = yylhsminor.yy167;
         break;
       case 93: /* expression ::= FALSE */
-#line 268 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[0].minor.yy167 = new_bool_expression(ctx, 0); }
-#line 2241 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 243 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_bool_expression(ctx, yymsp[0].minor.yy0.where, 0); }
+#line 2156 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[0].minor.yy167 = yylhsminor.yy167;
         break;
       case 94: /* expression ::= LPAREN expression RPAREN */
-#line 269 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-2].minor.yy167 = new_parentheses_expression(ctx, yymsp[-1].minor.yy167); }
-#line 2246 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 244 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_parentheses_expression(ctx, yymsp[-2].minor.yy0.where, yymsp[-1].minor.yy167); }
+#line 2162 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 95: /* expression ::= IDENTIFIER arguments */
-#line 270 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_fncall_expression(ctx, yymsp[-1].minor.yy0.string, yymsp[0].minor.yy93); }
-#line 2251 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 245 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_fncall_expression(ctx, yymsp[-1].minor.yy0.where, yymsp[-1].minor.yy0.value.string, yymsp[0].minor.yy93); }
+#line 2168 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-1].minor.yy167 = yylhsminor.yy167;
         break;
       case 96: /* expression ::= PLUS expression */
-#line 271 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy167 = new_unaryplus_expression(ctx, yymsp[0].minor.yy167); }
-#line 2257 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 246 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_unaryplus_expression(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy167); }
+#line 2174 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy167 = yylhsminor.yy167;
         break;
       case 97: /* expression ::= MINUS expression */
-#line 272 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy167 = new_unaryminus_expression(ctx, yymsp[0].minor.yy167); }
-#line 2262 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 247 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_unaryminus_expression(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy167); }
+#line 2180 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy167 = yylhsminor.yy167;
         break;
       case 98: /* expression ::= COMPLEMENT expression */
-#line 273 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy167 = new_unarycompl_expression(ctx, yymsp[0].minor.yy167); }
-#line 2267 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 248 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_unarycompl_expression(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy167); }
+#line 2186 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy167 = yylhsminor.yy167;
         break;
       case 99: /* expression ::= EXCLAMATION expression */
-#line 274 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yymsp[-1].minor.yy167 = new_unarynot_expression(ctx, yymsp[0].minor.yy167); }
-#line 2272 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 249 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_unarynot_expression(ctx, yymsp[-1].minor.yy0.where, yymsp[0].minor.yy167); }
+#line 2192 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+  yymsp[-1].minor.yy167 = yylhsminor.yy167;
         break;
       case 100: /* expression ::= expression STAR expression */
-#line 275 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_multiply_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2277 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 250 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_multiply_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2198 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 101: /* expression ::= expression SLASH expression */
-#line 276 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_divide_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2283 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 251 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_divide_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2204 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 102: /* expression ::= expression PERCENT expression */
-#line 277 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_mod_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2289 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 252 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_mod_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2210 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 103: /* expression ::= expression PLUS expression */
-#line 278 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_addition_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2295 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 253 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_addition_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2216 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 104: /* expression ::= expression MINUS expression */
-#line 279 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_subtraction_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2301 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 254 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_subtraction_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2222 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 105: /* expression ::= expression LSHIFT expression */
-#line 280 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_lshift_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2307 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 255 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_lshift_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2228 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 106: /* expression ::= expression RSHIFT expression */
-#line 281 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_rshift_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2313 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 256 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_rshift_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2234 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 107: /* expression ::= expression LT expression */
-#line 282 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_lt_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2319 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 257 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_lt_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2240 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 108: /* expression ::= expression GT expression */
-#line 283 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_gt_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2325 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 258 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_gt_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2246 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 109: /* expression ::= expression LEQ expression */
-#line 284 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_leq_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2331 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 259 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_leq_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2252 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 110: /* expression ::= expression GEQ expression */
-#line 285 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_geq_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2337 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 260 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_geq_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2258 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 111: /* expression ::= expression EQL expression */
-#line 286 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_eql_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2343 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 261 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_eql_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2264 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 112: /* expression ::= expression NEQ expression */
-#line 287 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_neq_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2349 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 262 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_neq_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2270 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 113: /* expression ::= expression AND expression */
-#line 288 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_and_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2355 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 263 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_and_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2276 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 114: /* expression ::= expression XOR expression */
-#line 289 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_xor_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2361 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 264 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_xor_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2282 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 115: /* expression ::= expression OR expression */
-#line 290 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_or_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2367 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 265 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_or_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2288 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 116: /* expression ::= expression ANDAND expression */
-#line 291 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_andand_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2373 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 266 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_andand_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2294 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 117: /* expression ::= expression OROR expression */
-#line 292 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_oror_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2379 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 267 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_oror_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2300 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       case 118: /* expression ::= expression QUESTION expression COLON expression */
-#line 293 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_conditional_expression(ctx, yymsp[-4].minor.yy167, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
-#line 2385 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 268 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_conditional_expression(ctx, node_location(yymsp[-4].minor.yy167), yymsp[-4].minor.yy167, yymsp[-2].minor.yy167, yymsp[0].minor.yy167); }
+#line 2306 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-4].minor.yy167 = yylhsminor.yy167;
         break;
       case 119: /* expression ::= expression LBRACKET expression RBRACKET */
-#line 294 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_array_dereference_expression(ctx, yymsp[-3].minor.yy167, yymsp[-1].minor.yy167); }
-#line 2391 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 269 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_array_dereference_expression(ctx, node_location(yymsp[-3].minor.yy167), yymsp[-3].minor.yy167, yymsp[-1].minor.yy167); }
+#line 2312 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-3].minor.yy167 = yylhsminor.yy167;
         break;
       case 120: /* expression ::= expression DOT IDENTIFIER */
-#line 295 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
-{ yylhsminor.yy167 = new_struct_dereference_expression(ctx, yymsp[-2].minor.yy167, yymsp[0].minor.yy0.string); }
-#line 2397 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 270 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.lemon"
+{ yylhsminor.yy167 = new_struct_dereference_expression(ctx, node_location(yymsp[-2].minor.yy167), yymsp[-2].minor.yy167, yymsp[0].minor.yy0.value.string); }
+#line 2318 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
   yymsp[-2].minor.yy167 = yylhsminor.yy167;
         break;
       default:
@@ -2442,7 +2363,7 @@ static void yy_parse_failed(
 
     // !!! FIXME: make this a proper fail() function.
     fail(ctx, "Giving up. Parser is hopelessly lost...");
-#line 2446 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2367 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
 /************ End %parse_failure code *****************************************/
   ParseSDLSLARG_STORE /* Suppress warning about unused %extra_argument variable */
   ParseSDLSLCTX_STORE
@@ -2465,7 +2386,7 @@ static void yy_syntax_error(
 
     // !!! FIXME: make this a proper fail() function.
     fail(ctx, "Syntax error");
-#line 2469 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
+#line 2390 "/home/icculus/projects/SDL_shader_tools/SDL_shader_parser.h"
 /************ End %syntax_error code ******************************************/
   ParseSDLSLARG_STORE /* Suppress warning about unused %extra_argument variable */
   ParseSDLSLCTX_STORE
@@ -259,46 +259,20 @@ static void internal_include_close(const char *data, SDL_SHADER_Malloc m, SDL_SH
 }
 
 
-/* !!! FIXME: maybe use these pool magic elsewhere? */
-/* !!! FIXME: maybe just get rid of this? (maybe the fragmentation isn't a big deal?) */
-
-/* Pool stuff... */
-/* ugh, I hate this macro salsa. */
-#define FREE_POOL(type, poolname) \
-    static void free_##poolname##_pool(Context *ctx) { \
-        type *item = ctx->poolname##_pool; \
-        while (item != NULL) { \
-            type *next = item->next; \
-            Free(ctx, item); \
-            item = next; \
-        } \
-    }
-
-#define GET_POOL(type, poolname) \
+/* Pool stuff... the actual allocator is MemPool in SDL_shader_common.c,
+   these just give us typed, zeroed objects out of the Context's pools. */
+#define IMPLEMENT_POOL(type, poolname) \
     static type *get_##poolname(Context *ctx) { \
-        type *retval = ctx->poolname##_pool; \
-        if (retval != NULL) { \
-            ctx->poolname##_pool = retval->next; \
-        } else { \
-            retval = (type *) Malloc(ctx, sizeof (type)); \
-        } \
+        type *retval = (type *) pool_alloc(ctx->poolname##_pool); \
         if (retval != NULL) { \
             SDL_zerop(retval); \
         } \
         return retval; \
-    }
-
-#define PUT_POOL(type, poolname) \
+    } \
     static void put_##poolname(Context *ctx, type *item) { \
-        item->next = ctx->poolname##_pool; \
-        ctx->poolname##_pool = item; \
+        pool_free(ctx->poolname##_pool, item); \
     }
 
-#define IMPLEMENT_POOL(type, poolname) \
-    FREE_POOL(type, poolname) \
-    GET_POOL(type, poolname) \
-    PUT_POOL(type, poolname)
-
 IMPLEMENT_POOL(Conditional, conditional)
 IMPLEMENT_POOL(IncludeState, include)
 IMPLEMENT_POOL(Define, define)
@@ -306,21 +280,22 @@ IMPLEMENT_POOL(Define, define)
 
 /* Preprocessor define hashtable stuff... */
 
-/* !!! FIXME: why isn't this using SDL_shader_common.c's code? */
-
-/* this is djb's xor hashing function. */
-static inline Uint32 hash_string_djbxor(const char *sym)
+/* the define table only uses the low byte of hash_string(), so identifiers
+   can use the hash the lexer already made for them. */
+static inline Uint8 hash_define_len(const char *sym, const size_t len)
 {
-    Uint32 hash = 5381;
-    while (*sym) {
-        hash = ((hash << 5) + hash) ^ *(sym++);
-    }
-    return hash;
+    return (Uint8) hash_string(sym, len);
 }
 
 static inline Uint8 hash_define(const char *sym)
 {
-    return (Uint8) hash_string_djbxor(sym);
+    return hash_define_len(sym, SDL_strlen(sym));
+}
+
+/* does NULL-terminated `identifier` match the `len` chars of `sym`? */
+static inline SDL_bool define_name_matches(const char *identifier, const char *sym, const size_t len)
+{
+    return ((SDL_strncmp(identifier, sym, len) == 0) && (identifier[len] == '\0')) ? SDL_TRUE : SDL_FALSE;
 }
 
 static int add_define(Context *ctx, const char *sym, const char *val,
@@ -388,14 +363,17 @@ static int remove_define(Context *ctx, const char *sym)
     return 0;
 }
 
-static const Define *find_define(Context *ctx, const char *sym)
+/* `sym` doesn't have to be NULL-terminated, and `hash` must be hash_define_len(sym, len). */
+static const Define *find_define_len(Context *ctx, const char *sym, const size_t len, const Uint8 hash)
 {
     const Uint8 filestrhash = 67;
     const Uint8 linestrhash = 75;
-    const Uint8 hash = hash_define(sym);
     Define *bucket = ctx->define_hashtable[hash];
+
+    SDL_assert(hash == hash_define_len(sym, len));
+
     while (bucket) {
-        if (SDL_strcmp(bucket->identifier, sym) == 0) {
+        if (define_name_matches(bucket->identifier, sym, len)) {
             return bucket;
         }
         bucket = bucket->next;
@@ -404,35 +382,36 @@ static const Define *find_define(Context *ctx, const char *sym)
     SDL_assert(hash_define("__FILE__") == filestrhash);
     SDL_assert(hash_define("__LINE__") == linestrhash);
 
-    if ( (hash == filestrhash) && (ctx->file_macro) && (SDL_strcmp(sym, "__FILE__") == 0) ) {
+    if ( (hash == filestrhash) && (ctx->file_macro) && (len == 8) && (SDL_memcmp(sym, "__FILE__", 8) == 0) ) {
         const IncludeState *state = ctx->include_stack;
         const char *fname = state ? state->filename : "";
         const size_t len = SDL_strlen(fname) + 3;
         char *str;
 
-        Free(ctx, (char *) ctx->file_macro->definition);
-        str = (char *) Malloc(ctx, len);
+        str = (char *) Malloc(ctx, (len - 1) + LEXER_PADDING);  /* this gets lexed, so it needs padding. */
         if (!str) {
             return NULL;
         }
+        Free(ctx, (char *) ctx->file_macro->definition);
         str[0] = '\"';
         SDL_memcpy(str + 1, fname, len - 3);
         str[len - 2] = '\"';
-        str[len - 1] = '\0';
+        SDL_memset(str + (len - 1), '\0', LEXER_PADDING);
         ctx->file_macro->definition = str;
         return ctx->file_macro;
-    } else if ( (hash == linestrhash) && (ctx->line_macro) && (SDL_strcmp(sym, "__LINE__") == 0) ) {
+    } else if ( (hash == linestrhash) && (ctx->line_macro) && (len == 8) && (SDL_memcmp(sym, "__LINE__", 8) == 0) ) {
         const IncludeState *state = ctx->include_stack;
         const size_t bufsize = 32;
         char *str;
 
-        Free(ctx, (char *) ctx->line_macro->definition);
         str = (char *) Malloc(ctx, bufsize);
         if (!str) {
             return 0;
         }
+        Free(ctx, (char *) ctx->line_macro->definition);
+        SDL_memset(str, '\0', bufsize);  /* this gets lexed, so it needs padding. */
         const size_t len = SDL_snprintf(str, bufsize, "%u", state->line);
-        SDL_assert(len < bufsize);
+        SDL_assert((len + LEXER_PADDING) <= bufsize);
         ctx->line_macro->definition = str;
         return ctx->line_macro;
     }
@@ -440,15 +419,17 @@ static const Define *find_define(Context *ctx, const char *sym)
     return NULL;
 }
 
+static const Define *find_define(Context *ctx, const char *sym)
+{
+    const size_t len = SDL_strlen(sym);
+    return find_define_len(ctx, sym, len, hash_define_len(sym, len));
+}
+
 static const Define *find_define_by_token(Context *ctx)
 {
     IncludeState *state = ctx->include_stack;
-    char *sym;
     SDL_assert(state->tokenval == TOKEN_IDENTIFIER);
-    sym = (char *) alloca(state->tokenlen+1);
-    SDL_memcpy(sym, state->token, state->tokenlen);
-    sym[state->tokenlen] = '\0';
-    return find_define(ctx, sym);
+    return find_define_len(ctx, state->token, state->tokenlen, (Uint8) state->tokenhash);
 }
 
 static const Define *find_macro_arg(const IncludeState *state,
@@ -484,9 +465,36 @@ static void put_all_defines(Context *ctx)
     }
 }
 
+static inline SDL_bool source_is_padded(const char *source, const size_t srclen)
+{
+    size_t i;
+    for (i = 0; i < LEXER_PADDING; i++) {
+        if (source[srclen + i] != '\0') {
+            return SDL_FALSE;
+        }
+    }
+    return SDL_TRUE;
+}
+
+/* copies a source we don't control into a buffer with room for the lexer's padding. */
+static char *pad_source(Context *ctx, const char *source, const size_t srclen)
+{
+    char *retval = (char *) Malloc(ctx, srclen + LEXER_PADDING);
+    if (retval != NULL) {
+        SDL_memcpy(retval, source, srclen);
+        SDL_memset(retval + srclen, '\0', LEXER_PADDING);
+    }
+    return retval;
+}
+
+/* `source` must be followed by LEXER_PADDING null bytes; use pad_source() if it isn't. */
 static SDL_bool push_source(Context *ctx, const char *fname, const char *source, size_t srclen, Sint32 linenum, SDL_SHADER_IncludeClose close_callback)
 {
-    IncludeState *state = get_include(ctx);
+    IncludeState *state;
+
+    SDL_assert(source_is_padded(source, srclen));
+
+    state = get_include(ctx);
     if (state == NULL) {
         return SDL_FALSE;
     }
@@ -526,15 +534,57 @@ static SDL_bool push_source(Context *ctx, const char *fname, const char *source,
     return SDL_TRUE;
 }
 
-static SDL_bool push_source_define(Context *ctx, const char *fname, const Define *def, Uint32 linenum)
+static SDL_bool push_source_define(Context *ctx, const char *fname, const Define *def, Uint32 linenum, size_t position)
 {
     const SDL_bool retval = push_source(ctx, fname, def->definition, SDL_strlen(def->definition), linenum, NULL);
     if (retval) {
         ctx->include_stack->current_define = def;
+        ctx->include_stack->invocation_position = position;
     }
     return retval;
 }
 
+/* for sources we built ourselves with Malloc(), like expanded macros. */
+static void close_define_include(const char *data, SDL_SHADER_Malloc m,
+                                 SDL_SHADER_Free f, void *d)
+{
+    f((void *) data, d);
+}
+
+/* Where the current token is, for error columns. Macro expansions aren't
+   files, so their tokens report where the macro was used instead. That's
+   recorded when the expansion is pushed, since by then a function-like
+   macro's invocation has already read up to its closing ')'. */
+static size_t current_source_position(const IncludeState *state)
+{
+    if (state == NULL) {
+        return 0;
+    } else if (state->position_base == 0) {
+        return state->invocation_position;
+    }
+    return state->position_base + (size_t) (state->token - state->source_base);
+}
+
+/* Sources are supposed to be UTF-8, so check each file once, right after it's
+   pushed, and point at the first thing that's wrong. This is only a warning,
+   since older shaders might have Latin-1 and such in their comments, which
+   the lexer skips anyhow. Bad bytes anywhere else (and bytes that are valid
+   UTF-8 but not legal SDLSL) are still errors from the lexer. */
+static void validate_source_utf8(Context *ctx)
+{
+    const IncludeState *state = ctx->include_stack;
+    const size_t bad = utf8_find_invalid(state->source_base, state->orig_length);
+    if (bad < state->orig_length) {
+        const Sint32 line = ctx->position;
+        const size_t position = ctx->source_position;
+        ctx->source_position = state->position_base ? (state->position_base + bad) : 0;
+        ctx->position = source_position_line(ctx, ctx->source_position);
+        warnf(ctx, "Invalid UTF-8 in source file (at byte offset %u)", (unsigned int) bad);
+        ctx->position = line;
+        ctx->source_position = position;
+    }
+}
+
 static void pop_source(Context *ctx)
 {
     IncludeState *state = ctx->include_stack;
@@ -547,7 +597,13 @@ static void pop_source(Context *ctx)
         return;
     }
 
-    if (state->close_callback) {
+    if (state->position_base != 0) {
+        source_position_close_file(ctx, state->position_base);
+    }
+
+    if (state->close_callback == close_define_include) {
+        close_define_include(state->source_base, MallocContextBridge, FreeContextBridge, ctx);
+    } else if (state->close_callback) {  /* the app's callbacks get the app's allocator. */
         state->close_callback(state->source_base, ctx->malloc,
                               ctx->free, ctx->malloc_data);
     }
@@ -564,6 +620,7 @@ static void pop_source(Context *ctx)
     ctx->include_stack = state->next;
     ctx->filename = ctx->include_stack ? ctx->include_stack->filename : NULL;
     ctx->position = ctx->include_stack ? ctx->include_stack->line : 0;
+    ctx->source_position = current_source_position(ctx->include_stack);
 
     print_debug_lexing_position(ctx);
 
@@ -571,13 +628,6 @@ static void pop_source(Context *ctx)
 }
 
 
-static void close_define_include(const char *data, SDL_SHADER_Malloc m,
-                                 SDL_SHADER_Free f, void *d)
-{
-    f((void *) data, d);
-}
-
-
 SDL_bool preprocessor_start(Context *ctx, const SDL_SHADER_CompilerParams *params, SDL_bool asm_comments)
 {
     char *define_include = NULL;
@@ -601,8 +651,25 @@ SDL_bool preprocessor_start(Context *ctx, const SDL_SHADER_CompilerParams *param
     ctx->close_callback = params->include_close ? params->include_close : internal_include_close;
     ctx->asm_comments = asm_comments;
 
-    ctx->filename_cache = stringcache_create(MallocContextBridge, FreeContextBridge, ctx);
-    okay = ((okay) && (ctx->filename_cache != NULL));
+    /* these might still be around from a previous run if the context is reusable. */
+    if (!ctx->conditional_pool) {
+        ctx->conditional_pool = pool_create(sizeof (Conditional), MallocContextBridge, FreeContextBridge, ctx);
+    }
+    if (!ctx->include_pool) {
+        ctx->include_pool = pool_create(sizeof (IncludeState), MallocContextBridge, FreeContextBridge, ctx);
+    }
+    if (!ctx->define_pool) {
+        ctx->define_pool = pool_create(sizeof (Define), MallocContextBridge, FreeContextBridge, ctx);
+    }
+    if (!ctx->buffer_pool) {
+        ctx->buffer_pool = bufferpool_create(MallocContextBridge, FreeContextBridge, ctx);
+    }
+    if (!ctx->filename_cache) {
+        ctx->filename_cache = stringcache_create(MallocContextBridge, FreeContextBridge, ctx);
+    }
+    if (!ctx->conditional_pool || !ctx->include_pool || !ctx->define_pool || !ctx->buffer_pool || !ctx->filename_cache) {
+        return SDL_FALSE;
+    }
 
     ctx->file_macro = get_define(ctx);
     okay = ((okay) && (ctx->file_macro != NULL));
@@ -618,7 +685,7 @@ SDL_bool preprocessor_start(Context *ctx, const SDL_SHADER_CompilerParams *param
 
     /* let the usual preprocessor parser sort these out. */
     if ((okay) && (params->define_count > 0)) {
-        Buffer *predefbuf = buffer_create(256, MallocContextBridge, FreeContextBridge, ctx);
+        Buffer *predefbuf = buffer_create_pooled(256, ctx->buffer_pool);
         okay = okay && (predefbuf != NULL);
         for (i = 0; okay && (i < params->define_count); i++) {
             okay = okay && buffer_append_fmt(predefbuf, "#define %s %s\n", params->defines[i].identifier, params->defines[i].definition);
@@ -626,14 +693,24 @@ SDL_bool preprocessor_start(Context *ctx, const SDL_SHADER_CompilerParams *param
 
         define_include_len = buffer_size(predefbuf);
         if (define_include_len > 0) {
-            define_include = buffer_flatten(predefbuf);
+            define_include = buffer_flatten_padded(predefbuf, LEXER_PADDING);
             okay = okay && (define_include != NULL);
         }
         buffer_destroy(predefbuf);
     }
 
-    if ((okay) && (!push_source(ctx, params->filename, params->source, params->sourcelen, 1, NULL))) {
-        okay = 0;
+    /* the app's source doesn't have the lexer's padding, so we lex a copy of it. */
+    if (okay) {
+        char *source = pad_source(ctx, params->source, params->sourcelen);
+        if (!source) {
+            okay = 0;
+        } else if (!push_source(ctx, params->filename, source, params->sourcelen, 1, close_define_include)) {
+            Free(ctx, source);
+            okay = 0;
+        } else {
+            ctx->include_stack->position_base = source_position_add_file(ctx, source, params->sourcelen);
+            validate_source_utf8(ctx);
+        }
     }
 
     if ((okay) && (define_include_len > 0)) {
@@ -650,27 +727,38 @@ SDL_bool preprocessor_start(Context *ctx, const SDL_SHADER_CompilerParams *param
 
 void preprocessor_end(Context *ctx)
 {
-    if (!ctx || !ctx->uses_preprocessor) {
+    if (!ctx) {
         return;
     }
 
-    while (ctx->include_stack != NULL) {
-        pop_source(ctx);
-    }
+    if (ctx->uses_preprocessor) {
+        while (ctx->include_stack != NULL) {
+            pop_source(ctx);
+        }
 
-    put_all_defines(ctx);
+        put_all_defines(ctx);
 
-    if (ctx->filename_cache != NULL) {
-        stringcache_destroy(ctx->filename_cache);
-    }
+        free_define(ctx, ctx->file_macro);
+        free_define(ctx, ctx->line_macro);
+        ctx->file_macro = NULL;
+        ctx->line_macro = NULL;
 
-    free_define(ctx, ctx->file_macro);
-    free_define(ctx, ctx->line_macro);
-    free_define_pool(ctx);
-    free_conditional_pool(ctx);
-    free_include_pool(ctx);
+        ctx->uses_preprocessor = SDL_FALSE;
+    }
 
-    ctx->uses_preprocessor = SDL_FALSE;
+    /* reusable contexts keep the pools and filenames for the next run. */
+    if (!ctx->reusable) {
+        stringcache_destroy(ctx->filename_cache);
+        pool_destroy(ctx->define_pool);
+        pool_destroy(ctx->conditional_pool);
+        pool_destroy(ctx->include_pool);
+        bufferpool_destroy(ctx->buffer_pool);
+        ctx->filename_cache = NULL;
+        ctx->define_pool = NULL;
+        ctx->conditional_pool = NULL;
+        ctx->include_pool = NULL;
+        ctx->buffer_pool = NULL;
+    }
 }
 
 
@@ -684,6 +772,47 @@ static inline void pushback(IncludeState *state)
 }
 
 
+/* just the parts of an IncludeState that lexing moves, so we can look ahead any number of tokens and rewind. */
+typedef struct LexerCheckpoint
+{
+    const char *source;
+    const char *token;
+    size_t tokenlen;
+    size_t bytes_left;
+    Token tokenval;
+    SDL_bool pushedback;
+    Sint32 line;
+    Uint32 tokenhash;
+} LexerCheckpoint;
+
+static inline void lexer_checkpoint(const IncludeState *state, LexerCheckpoint *cp)
+{
+    cp->source = state->source;
+    cp->token = state->token;
+    cp->tokenlen = state->tokenlen;
+    cp->bytes_left = state->bytes_left;
+    cp->tokenval = state->tokenval;
+    cp->pushedback = state->pushedback;
+    cp->line = state->line;
+    cp->tokenhash = state->tokenhash;
+}
+
+static inline void lexer_restore(IncludeState *state, const LexerCheckpoint *cp)
+{
+    #if DEBUG_PREPROCESSOR
+    printf("PREPROCESSOR RESTORE CHECKPOINT\n");
+    #endif
+    state->source = cp->source;
+    state->token = cp->token;
+    state->tokenlen = cp->tokenlen;
+    state->bytes_left = cp->bytes_left;
+    state->tokenval = cp->tokenval;
+    state->pushedback = cp->pushedback;
+    state->line = cp->line;
+    state->tokenhash = cp->tokenhash;
+}
+
+
 static Token lexer(IncludeState *state)
 {
     if (state->pushedback) {
@@ -740,6 +869,7 @@ static void handle_pp_include(Context *ctx)
     Token token = lexer(state);
     SDL_SHADER_IncludeType incltype;
     const char *newdata = NULL;
+    char *source = NULL;
     size_t newbytes = 0;
     char *filename = NULL;
     const char *updated_filename = NULL;
@@ -834,9 +964,16 @@ static void handle_pp_include(Context *ctx)
         return;
     }
 
-    if (!push_source(ctx, updated_filename, newdata, newbytes, 1, ctx->close_callback)) {
+    /* lex a padded copy, so we can hand the app's data right back. */
+    source = pad_source(ctx, newdata, newbytes);
+    ctx->close_callback(newdata, ctx->malloc, ctx->free, ctx->malloc_data);
+
+    if (source && !push_source(ctx, updated_filename, source, newbytes, 1, close_define_include)) {
         SDL_assert(ctx->out_of_memory);
-        ctx->close_callback(newdata, ctx->malloc, ctx->free, ctx->malloc_data);
+        Free(ctx, source);
+    } else if (source) {
+        ctx->include_stack->position_base = source_position_add_file(ctx, source, newbytes);
+        validate_source_utf8(ctx);
     }
 
     if (updated_filename != filename) {
@@ -948,6 +1085,7 @@ static void handle_pp_define(Context *ctx)
     SDL_bool done = SDL_FALSE;
     SDL_bool hashhash_error = SDL_FALSE;
     size_t buflen;
+    size_t flatlen;
     int params = 0;
     char **idents = NULL;
     char *definition = NULL;
@@ -994,10 +1132,10 @@ static void handle_pp_define(Context *ctx)
     if (state->tokenval == ((Token) ' ')) {
         lexer(state);  /* skip it. */
     } else if (state->tokenval == ((Token) '(')) {
-        IncludeState saved;
+        LexerCheckpoint saved;
         SDL_bool invalid = SDL_FALSE;
 
-        SDL_memcpy(&saved, state, sizeof (IncludeState));
+        lexer_checkpoint(state, &saved);
 
         if (lexer(state) != ((Token) ')')) {
             pushback(state);
@@ -1036,7 +1174,7 @@ static void handle_pp_define(Context *ctx)
             }
 
             /* roll all the way back, do it again. */
-            SDL_memcpy(state, &saved, sizeof (IncludeState));
+            lexer_restore(state, &saved);
             SDL_memset(idents, '\0', sizeof (char *) * params);
 
             int i;
@@ -1075,7 +1213,10 @@ static void handle_pp_define(Context *ctx)
 
     pushback(state);
 
-    buffer = buffer_create(128, MallocContextBridge, FreeContextBridge, ctx);
+    buffer = buffer_create_pooled(128, ctx->buffer_pool);
+    if (buffer == NULL) {
+        goto handle_pp_define_failed;
+    }
 
     state->report_whitespace = SDL_TRUE;
     while ((!done) && (!ctx->out_of_memory)) {
@@ -1104,9 +1245,10 @@ static void handle_pp_define(Context *ctx)
     }
     state->report_whitespace = SDL_FALSE;
 
-    buflen = buffer_size(buffer) + 1;
+    flatlen = buffer_size(buffer);
+    buflen = flatlen + 1;
     if (!ctx->out_of_memory) {
-        definition = buffer_flatten(buffer);
+        definition = buffer_flatten_padded(buffer, LEXER_PADDING);
     }
 
     buffer_destroy(buffer);
@@ -1136,6 +1278,9 @@ static void handle_pp_define(Context *ctx)
     }
 
     if (hashhash_error) {
+        /* the trimming above can leave bytes between the new end and the lexer's padding. */
+        const size_t deflen = SDL_strlen(definition);
+        SDL_memset(definition + deflen, '\0', flatlen - deflen);
         fail(ctx, "'##' cannot appear at either end of a macro expansion");
     }
 
@@ -1252,20 +1397,21 @@ static inline void handle_pp_ifndef(Context *ctx)
     _handle_pp_ifdef(ctx, TOKEN_PP_IFNDEF);
 }
 
-static SDL_bool replace_and_push_macro(Context *ctx, const Define *def, const Define *params)
+/* (line) and (position) are where the macro was used, not where its arguments ended. */
+static SDL_bool replace_and_push_macro(Context *ctx, const Define *def, const Define *params, const Uint32 line, const size_t position)
 {
     char *final = NULL;
     IncludeState *state;
     Buffer *buffer;
 
     /* We push the #define and lex it, building a buffer with argument replacement, stringification, and concatenation. */
-    buffer = buffer_create(128, MallocContextBridge, FreeContextBridge, ctx);
+    buffer = buffer_create_pooled(128, ctx->buffer_pool);
     if (buffer == NULL) {
         return SDL_FALSE;
     }
 
     state = ctx->include_stack;
-    if (!push_source_define(ctx, state->filename, def, state->line)) {
+    if (!push_source_define(ctx, state->filename, def, line, position)) {
         buffer_destroy(buffer);
         return SDL_FALSE;
     }
@@ -1338,7 +1484,7 @@ static SDL_bool replace_and_push_macro(Context *ctx, const Define *def, const De
         }
     }
 
-    final = buffer_flatten(buffer);
+    final = buffer_flatten_padded(buffer, LEXER_PADDING);
     if (!final) {
         goto replace_and_push_macro_failed;
     }
@@ -1346,12 +1492,13 @@ static SDL_bool replace_and_push_macro(Context *ctx, const Define *def, const De
     buffer_destroy(buffer);
     pop_source(ctx);  /* ditch the macro. */
     state = ctx->include_stack;
-    if (!push_source(ctx, state->filename, final, SDL_strlen(final), state->line, close_define_include)) {
+    if (!push_source(ctx, state->filename, final, SDL_strlen(final), line, close_define_include)) {
         Free(ctx, final);
         return SDL_FALSE;
     }
 
     ctx->include_stack->current_define = def;
+    ctx->include_stack->invocation_position = position;
 
     return SDL_TRUE;
 
@@ -1366,26 +1513,35 @@ static SDL_bool handle_macro_args(Context *ctx, const char *sym, const Define *d
 {
     SDL_bool retval = SDL_FALSE;
     IncludeState *state = ctx->include_stack;
+    const Uint32 line = state->line;  /* the arguments might go on for more lines. */
+    const size_t position = current_source_position(state);
     Define *params = NULL;
     const int expected = (def->paramcount < 0) ? 0 : def->paramcount;
     int saw_params = 0;
-    IncludeState saved;  /* can't pushback, we need the original token. */
+    LexerCheckpoint saved;  /* can't pushback, we need the original token. */
     SDL_bool void_call = SDL_FALSE;
     int paren = 1;
 
-    SDL_memcpy(&saved, state, sizeof (IncludeState));
+    lexer_checkpoint(state, &saved);
     if (lexer(state) != ((Token) '(')) {
-        SDL_memcpy(state, &saved, sizeof (IncludeState));
+        lexer_restore(state, &saved);
         goto handle_macro_args_failed;  /* gcc abandons replacement, too. */
     }
 
     state->report_whitespace = SDL_TRUE;
 
     while (paren > 0) {
-        Buffer *buffer = buffer_create(128, MallocContextBridge, FreeContextBridge, ctx);
-        Buffer *origbuffer = buffer_create(128, MallocContextBridge, FreeContextBridge, ctx);
+        Buffer *buffer = buffer_create_pooled(128, ctx->buffer_pool);
+        Buffer *origbuffer = buffer_create_pooled(128, ctx->buffer_pool);
+        Token t;
+
+        if ((buffer == NULL) || (origbuffer == NULL)) {
+            buffer_destroy(origbuffer);
+            buffer_destroy(buffer);
+            goto handle_macro_args_failed;
+        }
 
-        Token t = lexer(state);
+        t = lexer(state);
 
         SDL_assert(!void_call);
 
@@ -1508,7 +1664,7 @@ static SDL_bool handle_macro_args(Context *ctx, const char *sym, const Define *d
     }
 
     /* this handles arg replacement and the '##' and '#' operators. */
-    retval = replace_and_push_macro(ctx, def, params);
+    retval = replace_and_push_macro(ctx, def, params, line, position);
 
 handle_macro_args_failed:
     while (params) {
@@ -1538,22 +1694,18 @@ static SDL_bool handle_pp_identifier(Context *ctx)
     IncludeState *state = ctx->include_stack;
     const char *fname = state->filename;
     const Uint32 line = state->line;
-    char *sym = (char *) alloca(state->tokenlen+1);
     const Define *def;
 
-    SDL_memcpy(sym, state->token, state->tokenlen);
-    sym[state->tokenlen] = '\0';
-
     /* Is this identifier #defined? */
-    def = find_define(ctx, sym);
+    def = find_define_by_token(ctx);
 
     if ((def == NULL) || currently_preprocessing_macro(ctx, def)) {
         return SDL_FALSE;   /* just send the token through unchanged. */
     } else if (def->paramcount != 0) {
-        return handle_macro_args(ctx, sym, def);
+        return handle_macro_args(ctx, def->identifier, def);
     }
 
-    return push_source_define(ctx, fname, def, line);
+    return push_source_define(ctx, fname, def, line, current_source_position(state));
 }
 
 
@@ -1590,12 +1742,14 @@ static int find_precedence(const Token token)
 
 #define VERIFY_RPN_ARRAY_ALLOCATION(name, typ, increase, run_if_oom) \
     if (name##_size >= name##_allocsize) { \
-        void *ptr = Malloc(ctx, sizeof (typ) * (name##_allocsize + increase)); \
+        const size_t newlen = sizeof (typ) * (name##_allocsize + increase); \
+        void *ptr = name##_malloced ? Realloc(ctx, name##_malloced, newlen) : Malloc(ctx, newlen); \
         if (!ptr) { \
             run_if_oom; \
         } else { \
-            SDL_memcpy(ptr, name##_malloced ? name##_malloced : name##_stacked, sizeof (typ) * name##_size); \
-            Free(ctx, name##_malloced); \
+            if (!name##_malloced) { \
+                SDL_memcpy(ptr, name##_stacked, sizeof (typ) * name##_size); \
+            } \
             name = name##_malloced = (typ *) ptr; \
             name##_allocsize += increase; \
         } \
@@ -2031,6 +2185,67 @@ static void unterminated_pp_condition(Context *ctx)
     put_conditional(ctx, cond);
 }
 
+/* Bytes that can make a line in a disabled #if block matter to the lexer
+   beyond that line: newlines end it, and comments, string and char literals,
+   line continuations and nulls might carry on past it (or hide a '#' that
+   isn't a directive, etc). */
+static const ByteScan skip_scan = {
+    { ['\0'] = BYTESCAN_STOP, ['\n'] = BYTESCAN_STOP, ['\r'] = BYTESCAN_STOP, ['/'] = BYTESCAN_STOP,
+      ['"'] = BYTESCAN_STOP, ['\''] = BYTESCAN_STOP, ['\\'] = BYTESCAN_STOP },
+    { '\0', '\n', '\r', '/', '"', '\'', '\\' }, SDL_FALSE
+};
+
+/* When a disabled #if block is at the start of a line, race through whole
+   lines without tokenizing them, until one starts with a '#' (which might be
+   an #else or #endif) or has something on it that needs the real lexer.
+   The lexer then picks up from the start of that line, as if it had
+   tokenized and thrown away everything before it. */
+static void skip_inactive_lines(IncludeState *state)
+{
+    const Uint8 *ptr = (const Uint8 *) state->source;
+    const Uint8 *end = ptr + state->bytes_left;
+    Sint32 lines = 0;
+
+    SDL_assert(state->tokenval == ((Token) '\n'));
+    SDL_assert(!state->pushedback);
+
+    while (ptr < end) {
+        const Uint8 *linestart = ptr;
+
+        /* the source's null padding stops all of these scans at the end. */
+        while ((*ptr == ' ') || (*ptr == '\t') || (*ptr == '\v') || (*ptr == '\f')) {
+            ptr++;
+        }
+
+        if (*ptr == '#') {
+            ptr = linestart;  /* might be a directive we care about, let the lexer have it. */
+            break;
+        }
+
+        ptr = (const Uint8 *) scan_bytes((const char *) ptr, (const char *) (end + LEXER_PADDING), &skip_scan, NULL);
+
+        if ((*ptr != '\n') && (*ptr != '\r')) {
+            ptr = linestart;  /* no newline, or something tricky on this line; do it the slow way. */
+            break;
+        }
+
+        if ((*ptr == '\r') && (ptr[1] == '\n')) {
+            ptr++;
+        }
+        ptr++;
+        lines++;
+    }
+
+    if (lines > 0) {
+        const size_t skipped = (size_t) (((const char *) ptr) - state->source);
+        state->source = (const char *) ptr;
+        state->bytes_left -= skipped;
+        state->token = state->source;
+        state->tokenlen = 0;
+        state->line += lines;
+    }
+}
+
 static inline const char *_preprocessor_nexttoken(Context *ctx, size_t *_len, Token *_token)
 {
     while (SDL_TRUE) {
@@ -2045,18 +2260,24 @@ static inline const char *_preprocessor_nexttoken(Context *ctx, size_t *_len, To
             return NULL;  /* we're done! */
         }
 
-        ctx->position = state->line;
-        SDL_assert(ctx->filename == state->filename);  /* should be same pointer in a stringcache */
-
         cond = state->conditional_stack;
         skipping = ((cond != NULL) && (cond->skipping)) ? SDL_TRUE : SDL_FALSE;
 
+        if (skipping && !state->pushedback && (state->tokenval == ((Token) '\n'))) {
+            skip_inactive_lines(state);
+        }
+
+        ctx->position = state->line;
+        SDL_assert(ctx->filename == state->filename);  /* should be same pointer in a stringcache */
+
         state->report_whitespace = SDL_TRUE;
 
         token = lexer(state);
 
         state->report_whitespace = SDL_FALSE;
 
+        ctx->source_position = current_source_position(state);
+
         if (token == TOKEN_EOI) {
             SDL_assert(state->bytes_left == 0);
             if (state->conditional_stack != NULL) {
@@ -2150,6 +2371,20 @@ const char *preprocessor_nexttoken(Context *ctx, size_t *len, Token *token)
     return retval;
 }
 
+Uint32 preprocessor_tokenhash(Context *ctx)
+{
+    /* tokens always come from the top of the include stack, and it doesn't
+       change until the next preprocessor_nexttoken() call. */
+    const IncludeState *state = ctx->include_stack;
+    SDL_assert(state != NULL);
+    if (state->tokenval != TOKEN_IDENTIFIER) {
+        /* a macro call that failed can hand back an identifier after the
+           lexer moved on, so hash whatever text we actually returned. */
+        return hash_string(state->token, state->tokenlen);
+    }
+    return state->tokenhash;
+}
+
 
 static const SDL_SHADER_PreprocessData out_of_mem_data_preprocessor = {
     1, &SDL_SHADER_out_of_mem_error, 0, 0, 0, 0, 0
@@ -2158,7 +2393,7 @@ static const SDL_SHADER_PreprocessData out_of_mem_data_preprocessor = {
 
 /* public API... */
 
-const SDL_SHADER_PreprocessData *SDL_SHADER_Preprocess(const SDL_SHADER_CompilerParams *params, SDL_bool strip_comments)
+static const SDL_SHADER_PreprocessData *preprocess(const SDL_SHADER_CompilerParams *params, SDL_bool strip_comments, SDL_SHADER_OutputSink sink, void *sinkdata)
 {
     SDL_SHADER_PreprocessData *retval = NULL;
     Context *ctx = NULL;
@@ -2167,13 +2402,14 @@ const SDL_SHADER_PreprocessData *SDL_SHADER_Preprocess(const SDL_SHADER_Compiler
     const char *tokstr = NULL;
     int indent = 0;
     size_t len = 0;
-    char *output = NULL;
+    void *output = NULL;
+    SDL_SHADER_Error *errors = NULL;
     size_t errcount = 0;
     size_t total_bytes = 0;
     Token prev_token = TOKEN_UNKNOWN;
     SDL_bool whitespace_pending = SDL_FALSE;
 
-    ctx = context_create(params->allocate, params->deallocate, params->allocate_data);
+    ctx = context_create_from_params(params);
     if (ctx == NULL) {
         return &out_of_mem_data_preprocessor;
     }
@@ -2182,7 +2418,7 @@ const SDL_SHADER_PreprocessData *SDL_SHADER_Preprocess(const SDL_SHADER_Compiler
         goto preprocess_out_of_mem;
     }
 
-    buffer = buffer_create(4096, MallocContextBridge, FreeContextBridge, ctx);
+    buffer = buffer_create_pooled(4096, ctx->buffer_pool);
     if (buffer == NULL) {
         goto preprocess_out_of_mem;
     }
@@ -2228,35 +2464,46 @@ const SDL_SHADER_PreprocessData *SDL_SHADER_Preprocess(const SDL_SHADER_Compiler
     
     SDL_assert(token == TOKEN_EOI);
 
+    ctx->memphase = SDL_SHADER_MEMPHASE_OUTPUT;
     total_bytes = buffer_size(buffer);
-    output = buffer_flatten(buffer);
-    buffer_destroy(buffer);
-    buffer = NULL;  /* don't free this pointer again. */
 
-    if (output == NULL) {
-        goto preprocess_out_of_mem;
+    if (sink) {  /* hand the app our blocks directly, instead of copying them into one big string. */
+        const size_t chunk_count = buffer_iovec(buffer, NULL, 0);
+        SDL_SHADER_OutputChunk *chunks = (SDL_SHADER_OutputChunk *) Malloc(ctx, sizeof (SDL_SHADER_OutputChunk) * (chunk_count ? chunk_count : 1));
+        if (chunks == NULL) {
+            goto preprocess_out_of_mem;
+        }
+        buffer_iovec(buffer, chunks, chunk_count);
+        if (!sink(chunks, chunk_count, sinkdata)) {
+            ctx->filename = NULL;
+            ctx->position = SDL_SHADER_POSITION_AFTER;
+            fail(ctx, "Output callback failed");
+        }
+        Free(ctx, chunks);
     }
 
-    retval = (SDL_SHADER_PreprocessData *) Malloc(ctx, sizeof (*retval));
+    errcount = errorlist_count(ctx->errors);
+
+    /* the struct, errors, their strings and the output all go in one block, so the app can free it with one call. */
+    retval = (SDL_SHADER_PreprocessData *) errorlist_flatten(ctx->errors, sizeof (*retval), sink ? 0 : (total_bytes + 1), &errors, &output);
     if (retval == NULL) {
         goto preprocess_out_of_mem;
     }
 
-    SDL_zerop(retval);
-    errcount = errorlist_count(ctx->errors);
-    if (errcount > 0) {
-        retval->error_count = errcount;
-        retval->errors = errorlist_flatten(ctx->errors);
-        if (retval->errors == NULL) {
-            goto preprocess_out_of_mem;
-        }
+    if (!sink) {
+        buffer_flatten_into(buffer, (char *) output);
     }
+    buffer_destroy(buffer);
 
-    retval->output = output;
+    SDL_zerop(retval);
+    retval->error_count = errcount;
+    retval->errors = errors;
+    retval->output = (const char *) output;
     retval->output_len = total_bytes;
     retval->malloc = params->allocate;
     retval->free = params->deallocate;
     retval->malloc_data = params->allocate_data;
+    retval->memory = ctx->memstats;
 
     context_destroy(ctx);
 
@@ -2264,26 +2511,27 @@ const SDL_SHADER_PreprocessData *SDL_SHADER_Preprocess(const SDL_SHADER_Compiler
 
 preprocess_out_of_mem:
     SDL_assert(ctx != NULL);
-    if (retval != NULL) {
-        size_t i;
-        for (i = 0; i < retval->error_count; i++) {
-            Free(ctx, (void *) retval->errors[i].message);
-            Free(ctx, (void *) retval->errors[i].filename);
-        }
-        Free(ctx, retval);
-    }
-    Free(ctx, output);
     buffer_destroy(buffer);
     context_destroy(ctx);
     return &out_of_mem_data_preprocessor;
 }
 
+const SDL_SHADER_PreprocessData *SDL_SHADER_Preprocess(const SDL_SHADER_CompilerParams *params, SDL_bool strip_comments)
+{
+    return preprocess(params, strip_comments, NULL, NULL);
+}
+
+const SDL_SHADER_PreprocessData *SDL_SHADER_PreprocessToSink(const SDL_SHADER_CompilerParams *params, SDL_bool strip_comments, SDL_SHADER_OutputSink sink, void *userdata)
+{
+    SDL_assert(sink != NULL);
+    return preprocess(params, strip_comments, sink, userdata);
+}
+
 void SDL_SHADER_FreePreprocessData(const SDL_SHADER_PreprocessData *_data)
 {
     SDL_SHADER_PreprocessData *data = (SDL_SHADER_PreprocessData *) _data;
     SDL_SHADER_Free f;
     void *d;
-    int i;
 
     if ((data == NULL) || (data == &out_of_mem_data_preprocessor)) {
         return;
@@ -2292,15 +2540,7 @@ void SDL_SHADER_FreePreprocessData(const SDL_SHADER_PreprocessData *_data)
     f = (data->free == NULL) ? SDL_SHADER_internal_free : data->free;
     d = data->malloc_data;
 
-    f((void *) data->output, d);
-
-    for (i = 0; i < data->error_count; i++) {
-        f((void *) data->errors[i].message, d);
-        f((void *) data->errors[i].filename, d);
-    }
-    f((void *) data->errors, d);
-
-    f(data, d);
+    FreeReturnedData(f, d, data);  /* errors and output are in the same block. */
 }
 
 /* end of SDL_shader_preprocessor.c ... */
@@ -51,8 +51,26 @@ sub compare_files {
 
 my %tests = ();
 
-$tests{'output'} = sub {
-    my ($module, $fname) = @_;
+# preprocessor tests run twice: once streaming output through
+#  SDL_SHADER_PreprocessToSink(), and once with SDL_SHADER_Preprocess().
+my @preprocessor_variants = ('', ' --flat-output');
+
+sub run_variants {
+    my ($module, $fname, $fn) = @_;
+    my @variants = ($module eq 'preprocessor') ? @preprocessor_variants : ('');
+    foreach (@variants) {
+        my $variant = $_;
+        my ($rc, $reason) = &$fn($module, $fname, $variant);
+        if ($rc != 1) {
+            $reason .= " with$variant" if (($variant ne '') and (defined $reason));
+            return ($rc, $reason);
+        }
+    }
+    return (1);
+}
+
+sub output_test {
+    my ($module, $fname, $variant) = @_;
     my $output = 'unittest_tempoutput';
     my $desired = $fname . '.correct';
     my $cmd = undef;
@@ -60,7 +78,9 @@ $tests{'output'} = sub {
 
     # !!! FIXME: this should go elsewhere.
     if ($module eq 'preprocessor') {
-        $cmd = "$binpath/sdl-shader-compiler -P '$fname' -o '$output'";
+        $cmd = "$binpath/sdl-shader-compiler -P$variant '$fname' -o '$output'";
+    } elsif ($module eq 'parser') {
+        $cmd = "$binpath/sdl-shader-compiler -T '$fname' -o '$output'";
     } else {
         return (0, "Don't know how to do this module type");
     }
@@ -78,19 +98,148 @@ $tests{'output'} = sub {
     my @retval = compare_files($desired, $output, $endlines);
     unlink($output);
     return @retval;
+}
+
+sub errors_test {
+    my ($module, $fname, $variant) = @_;
+    my $error_output = 'unittest_temperroutput';
+    my $output = 'unittest_tempoutput';
+    my $desired = $fname . '.correct';
+    my $desired_output = $fname . '.stdout.correct';
+    my $cmd = undef;
+    my $endlines = 1;
+
+    # !!! FIXME: this should go elsewhere.
+    if ($module eq 'preprocessor') {
+        $cmd = "$binpath/sdl-shader-compiler -P$variant '$fname'";
+    } elsif ($module eq 'compiler') {
+        # compiler errors are mostly about AST nodes, so check their columns, too.
+        $cmd = "$binpath/sdl-shader-compiler -C --error-columns '$fname'";
+    } else {
+        return (0, "Don't know how to do this module type");
+    }
+    $cmd .= " 2>$error_output 1>$output";
+
+    print("$cmd\n") if ($GPrintCmds);
+
+    system($cmd);
+
+    if (not -f $error_output) {
+        unlink($output) if (-f $output);
+        return (0, "Didn't get any error output");
+    }
+
+    my @retval = compare_files($desired, $error_output, $endlines);
+    unlink($error_output);
+
+    # whatever was output before the errors has to match, too: nothing, unless there's a .stdout.correct file.
+    if ($retval[0] == 1) {
+        if (-f $desired_output) {
+            @retval = compare_files($desired_output, $output, $endlines);
+            $retval[1] = "Output doesn't match expectations" if ($retval[0] != 1);
+        } elsif (-s $output) {
+            @retval = (0, "Wrote output, but there's no .stdout.correct file");
+        }
+    }
+
+    unlink($output) if (-f $output);
+    return @retval;
+}
+
+$tests{'output'} = sub {
+    my ($module, $fname) = @_;
+    return run_variants($module, $fname, \&output_test);
 };
 
 $tests{'errors'} = sub {
     my ($module, $fname) = @_;
+    return run_variants($module, $fname, \&errors_test);
+};
+
+# these run with the CLI's tracking allocator, which reports leaks and size mismatches on stderr.
+sub allocator_test {
+    my ($module, $fname, $variant) = @_;
     my $error_output = 'unittest_temperroutput';
-    my $output = 'unittest_tempoutput';
     my $desired = $fname . '.correct';
     my $cmd = undef;
     my $endlines = 1;
 
     # !!! FIXME: this should go elsewhere.
     if ($module eq 'preprocessor') {
-        $cmd = "$binpath/sdl-shader-compiler -P '$fname' -o '$output'";
+        $cmd = "$binpath/sdl-shader-compiler -P$variant --check-allocator '$fname'";
+    } elsif ($module eq 'compiler') {
+        $cmd = "$binpath/sdl-shader-compiler -C --error-columns --check-allocator '$fname'";
+    } else {
+        return (0, "Don't know how to do this module type");
+    }
+    $cmd .= " 2>$error_output 1>/dev/null";
+
+    print("$cmd\n") if ($GPrintCmds);
+
+    system($cmd);
+
+    if (not -f $error_output) { return (0, "Didn't get any error output"); }
+
+    my @retval = compare_files($desired, $error_output, $endlines);
+    unlink($error_output);
+    return @retval;
+}
+
+$tests{'allocator'} = sub {
+    my ($module, $fname) = @_;
+    return run_variants($module, $fname, \&allocator_test);
+};
+
+# these write their output to a closed stdout, so the output callback fails.
+$tests{'write-errors'} = sub {
+    my ($module, $fname) = @_;
+    my $error_output = 'unittest_temperroutput';
+    my $desired = $fname . '.correct';
+    my $cmd = undef;
+    my $endlines = 1;
+
+    # !!! FIXME: this should go elsewhere.
+    if ($module eq 'preprocessor') {
+        $cmd = "$binpath/sdl-shader-compiler -P '$fname'";
+    } else {
+        return (0, "Don't know how to do this module type");
+    }
+    $cmd .= " 2>$error_output 1>&-";
+
+    print("$cmd\n") if ($GPrintCmds);
+
+    system($cmd);
+
+    if (not -f $error_output) { return (0, "Didn't get any error output"); }
+
+    my @retval = compare_files($desired, $error_output, $endlines);
+    unlink($error_output);
+    return @retval;
+};
+
+$tests{'session'} = sub {
+    my ($module, $fname) = @_;
+    my $error_output = 'unittest_temperroutput';
+    my $desired = $fname . '.correct';
+    my $cmd = undef;
+    my $endlines = 1;
+
+    # each test is a list of shaders, one per line, to run through a single compiler session.
+    if (not open(LISTFILE, '<', $fname)) {
+        return (0, "Couldn't open '$fname' for reading");
+    }
+    my $dir = $fname;
+    $dir =~ s/\/[^\/]*\Z//;
+    my @files = ();
+    while (<LISTFILE>) {
+        s/[\r\n]//g;
+        push(@files, "'$dir/$_'") if ($_ ne '');
+    }
+    close(LISTFILE);
+
+    # !!! FIXME: this should go elsewhere.
+    if ($module eq 'compiler') {
+        $cmd = "$binpath/sdl-shader-compiler -C " . join(' ', @files);
     } else {
         return (0, "Don't know how to do this module type");
     }
@@ -99,7 +248,6 @@ $tests{'errors'} = sub {
     print("$cmd\n") if ($GPrintCmds);
 
     system($cmd);
-    unlink($output) if (-f $output);
 
     if (not -f $error_output) { return (0, "Didn't get any error output"); }
 
@@ -9,6 +9,12 @@
 #include <string.h>
 #include <assert.h>
 
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
 #include "SDL_shader_compiler.h"
 #include "SDL_shader_ast.h"
 
@@ -39,6 +45,99 @@ static void UtilFree(void *_ptr, void *d)
 #endif
 
 
+/* --check-allocator installs all four allocator hooks, remembers the size of
+   every allocation, and complains at exit about leaks, or about reallocs and
+   sized frees that don't agree with what we actually handed out. */
+static SDL_bool check_allocator = SDL_FALSE;
+
+typedef union CheckAllocHeader
+{
+    size_t len;
+    long double alignment;  /* keep the library's pointer aligned. */
+    void *ptr;
+} CheckAllocHeader;
+
+static struct
+{
+    size_t live_allocations;
+    size_t live_bytes;
+    size_t size_mismatches;
+    size_t reallocs;
+    size_t sized_frees;
+} check_alloc;
+
+static void * SDLCALL CheckMalloc(size_t bytes, void *d)
+{
+    CheckAllocHeader *hdr = (CheckAllocHeader *) SDL_malloc(sizeof (CheckAllocHeader) + bytes);
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->len = bytes;
+    check_alloc.live_allocations++;
+    check_alloc.live_bytes += bytes;
+    return hdr + 1;
+}
+
+static void * SDLCALL CheckRealloc(void *ptr, size_t oldbytes, size_t newbytes, void *d)
+{
+    CheckAllocHeader *hdr;
+    size_t len;
+
+    check_alloc.reallocs++;
+
+    if ((ptr == NULL) || (newbytes == 0)) {  /* the API promises we never see these. */
+        check_alloc.size_mismatches++;
+        return NULL;
+    }
+
+    hdr = ((CheckAllocHeader *) ptr) - 1;
+    len = hdr->len;
+    if (len != oldbytes) {
+        check_alloc.size_mismatches++;
+    }
+
+    hdr = (CheckAllocHeader *) SDL_realloc(hdr, sizeof (CheckAllocHeader) + newbytes);
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->len = newbytes;
+    check_alloc.live_bytes -= len;
+    check_alloc.live_bytes += newbytes;
+    return hdr + 1;
+}
+
+static void SDLCALL CheckFree(void *ptr, void *d)
+{
+    if (ptr != NULL) {
+        CheckAllocHeader *hdr = ((CheckAllocHeader *) ptr) - 1;
+        check_alloc.live_allocations--;
+        check_alloc.live_bytes -= hdr->len;
+        SDL_free(hdr);
+    }
+}
+
+static void SDLCALL CheckSizedFree(void *ptr, size_t bytes, void *d)
+{
+    check_alloc.sized_frees++;
+    if ((ptr != NULL) && (((CheckAllocHeader *) ptr) - 1)->len != bytes) {
+        check_alloc.size_mismatches++;
+    }
+    CheckFree(ptr, d);
+}
+
+/* prints what --check-allocator saw; returns SDL_FALSE if anything was wrong. */
+static SDL_bool report_allocator_check(void)
+{
+    fprintf(stderr, "allocator: %llu allocations (%llu bytes) still live, %llu size mismatches, reallocate %s, sized_deallocate %s.\n",
+            (unsigned long long) check_alloc.live_allocations,
+            (unsigned long long) check_alloc.live_bytes,
+            (unsigned long long) check_alloc.size_mismatches,
+            check_alloc.reallocs ? "used" : "unused",
+            check_alloc.sized_frees ? "used" : "unused");
+    return ((check_alloc.live_allocations == 0) && (check_alloc.size_mismatches == 0)) ? SDL_TRUE : SDL_FALSE;
+}
+
+
 static void fail(const char *err)
 {
     fprintf(stderr, "%s.\n", err);
@@ -46,16 +145,53 @@ static void fail(const char *err)
 }
 
 
-static void print_errors(const SDL_SHADER_Error *errors, const size_t error_count)
+static SDL_bool show_error_columns = SDL_FALSE;  /* "file:line:column:" instead of "file:line:", when the column is known. */
+
+/* prints errors and warnings both; returns SDL_TRUE if any were errors. */
+static SDL_bool print_errors(const SDL_SHADER_Error *errors, const size_t error_count)
 {
+    SDL_bool retval = SDL_FALSE;
     size_t i;
     for (i = 0; i < error_count; i++) {
-        fprintf(stderr, "%s:%d: %s: %s\n",
-                errors[i].filename ? errors[i].filename : "???",
-                errors[i].error_position,
-                errors[i].is_error ? "error" : "warning",
-                errors[i].message);
+        const char *fname = errors[i].filename ? errors[i].filename : "???";
+        const char *kind = errors[i].is_error ? "error" : "warning";
+        if (show_error_columns && (errors[i].error_column > 0)) {
+            fprintf(stderr, "%s:%d:%d: %s: %s\n", fname, errors[i].error_position, errors[i].error_column, kind, errors[i].message);
+        } else {
+            fprintf(stderr, "%s:%d: %s: %s\n", fname, errors[i].error_position, kind, errors[i].message);
+        }
+        if (errors[i].is_error) {
+            retval = SDL_TRUE;
+        }
     }
+    return retval;
+}
+
+static SDL_bool show_memory_stats = SDL_FALSE;
+
+static const char *memory_phases[] = { "preprocess", "parse", "semantic", "output" };
+SDL_COMPILE_TIME_ASSERT(memphases, SDL_arraysize(memory_phases) == SDL_SHADER_NUM_MEMPHASES);
+
+static void print_memory_stats(const SDL_SHADER_MemoryStats *stats)
+{
+    int i;
+
+    if (!show_memory_stats) {
+        return;
+    }
+
+    fprintf(stderr, "%-12s %14s %14s %12s\n", "memory", "current bytes", "peak bytes", "allocations");
+    for (i = 0; i < SDL_SHADER_NUM_MEMPHASES; i++) {
+        const SDL_SHADER_MemoryUsage *usage = &stats->phases[i];
+        fprintf(stderr, "%-12s %14llu %14llu %12llu\n", memory_phases[i],
+                (unsigned long long) usage->current_bytes,
+                (unsigned long long) usage->peak_bytes,
+                (unsigned long long) usage->allocations);
+    }
+    fprintf(stderr, "%-12s %14llu %14llu %12llu\n", "total",
+            (unsigned long long) stats->total.current_bytes,
+            (unsigned long long) stats->total.peak_bytes,
+            (unsigned long long) stats->total.allocations);
 }
 
 static void print_ast(FILE *io, const SDL_bool substmt, const void *_ast)
@@ -158,13 +294,18 @@ static void print_ast(FILE *io, const SDL_bool substmt, const void *_ast)
             break;
 
         case SDL_SHADER_AST_OP_FLOAT_LITERAL: {
+            /* print as few digits as it takes to get the exact same double back, so tests can check the parser's rounding. */
             const double f = ast->floatliteral.value;
-            const long long flr = (long long) f;
-            if (((float) flr) == f) {
-                fprintf(io, "%lld.0", flr);
-            } else {
-                fprintf(io, "%.16g", f);
+            char buf[64];
+            int precision;
+            for (precision = 15; precision < 17; precision++) {
+                SDL_snprintf(buf, sizeof (buf), "%.*g", precision, f);
+                if (SDL_strtod(buf, NULL) == f) {
+                    break;
+                }
             }
+            SDL_snprintf(buf, sizeof (buf), "%.*g", precision, f);
+            fprintf(io, "%s%s", buf, strpbrk(buf, ".en") ? "" : ".0");  /* "n" for inf and nan. */
             break;
         }
 
@@ -484,29 +625,99 @@ static void print_ast(FILE *io, const SDL_bool substmt, const void *_ast)
     #undef DO_INDENT
 }
 
+/* write the preprocessor's output blocks straight out, without flattening them into one string first. */
+static SDL_bool SDLCALL write_output_chunks(const SDL_SHADER_OutputChunk *chunks, size_t chunk_count, void *userdata)
+{
+    FILE *io = (FILE *) userdata;
+#ifdef _WIN32
+    size_t i;
+    for (i = 0; i < chunk_count; i++) {
+        if ((chunks[i].len > 0) && (fwrite(chunks[i].data, chunks[i].len, 1, io) != 1)) {
+            return SDL_FALSE;
+        }
+    }
+    return SDL_TRUE;
+#else
+    struct iovec iov[64];
+    const int fd = fileno(io);
+    size_t skip = 0;  /* bytes of chunks[0] that are already written. */
+
+    if (fflush(io) == EOF) {
+        return SDL_FALSE;
+    }
+
+    while (chunk_count > 0) {
+        ssize_t rc;
+        int iovcount = 0;
+
+        if (chunks->len == skip) {  /* done with this one (or it was empty). */
+            chunks++;
+            chunk_count--;
+            skip = 0;
+            continue;
+        }
+
+        while ((iovcount < (int) SDL_arraysize(iov)) && (((size_t) iovcount) < chunk_count)) {
+            const size_t offset = (iovcount == 0) ? skip : 0;
+            iov[iovcount].iov_base = ((char *) chunks[iovcount].data) + offset;
+            iov[iovcount].iov_len = chunks[iovcount].len - offset;
+            iovcount++;
+        }
+
+        rc = writev(fd, iov, iovcount);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return SDL_FALSE;
+        }
+
+        /* move past whatever made it out; this might end partway through a chunk. */
+        while ((rc > 0) && (chunk_count > 0)) {
+            const size_t avail = chunks->len - skip;
+            if (((size_t) rc) < avail) {
+                skip += (size_t) rc;
+                rc = 0;
+            } else {
+                rc -= (ssize_t) avail;
+                chunks++;
+                chunk_count--;
+                skip = 0;
+            }
+        }
+    }
+
+    return SDL_TRUE;
+#endif
+}
+
+static SDL_bool flat_output = SDL_FALSE;  /* use SDL_SHADER_Preprocess() instead of streaming the output. */
+
 static int preprocess(const SDL_SHADER_CompilerParams *params, const char *outfile, FILE *io)
 {
     const SDL_SHADER_PreprocessData *pd;
     const char *srcprofile = NULL;  /* for now */
+    SDL_bool failed;
     int retval = 0;
 
-    pd = SDL_SHADER_Preprocess(params, SDL_TRUE);
-
-    if (pd->error_count > 0) {
-        print_errors(pd->errors, pd->error_count);
+    if (flat_output) {
+        pd = SDL_SHADER_Preprocess(params, SDL_TRUE);
+        assert((pd->output == NULL) || (pd->output[pd->output_len] == '\0'));  /* we promise this. */
     } else {
-        if (pd->output != NULL) {
-            const size_t len = pd->output_len;
-            if ((len) && (fwrite(pd->output, len, 1, io) != 1)) {
-                fprintf(stderr, " ... fwrite('%s') failed.\n", outfile);
-            } else if ((outfile != NULL) && (fclose(io) == EOF)) {
-                fprintf(stderr, " ... fclose('%s') failed.\n", outfile);
-            } else {
-                retval = 1;
-            }
-        }
+        pd = SDL_SHADER_PreprocessToSink(params, SDL_TRUE, write_output_chunks, io);
     }
 
+    /* the sink got everything we had even if there were errors, so write the flat output either way, too. */
+    failed = print_errors(pd->errors, pd->error_count);
+    if ((flat_output) && (pd->output_len > 0) && (fwrite(pd->output, pd->output_len, 1, io) != 1)) {
+        fprintf(stderr, " ... fwrite('%s') failed.\n", outfile);
+    } else if ((outfile != NULL) && (fclose(io) == EOF)) {
+        fprintf(stderr, " ... fclose('%s') failed.\n", outfile);
+    } else if (!failed) {  /* warnings are fine, but errors aren't. */
+        retval = 1;
+    }
+
+    print_memory_stats(&pd->memory);
     SDL_SHADER_FreePreprocessData(pd);
 
     return retval;
@@ -519,9 +730,7 @@ static int ast(const SDL_SHADER_CompilerParams *params, const char *outfile, FIL
 
     ad = SDL_SHADER_ParseAst(params);
     
-    if (ad->error_count > 0) {
-        print_errors(ad->errors, ad->error_count);
-    } else {
+    if (!print_errors(ad->errors, ad->error_count)) {
         print_ast(io, SDL_FALSE, ad->shader);
         if ((outfile != NULL) && (fclose(io) == EOF)) {
             fprintf(stderr, " ... fclose('%s') failed.\n", outfile);
@@ -530,26 +739,26 @@ static int ast(const SDL_SHADER_CompilerParams *params, const char *outfile, FIL
         }
     }
 
+    print_memory_stats(&ad->memory);
     SDL_SHADER_FreeAstData(ad);
 
     return retval;
 }
 
-static int compile(const SDL_SHADER_CompilerParams *params, const char *outfile, FILE *io)
+/* (compiler) is NULL for a one-off compile, otherwise we're compiling several files through one session. */
+static int compile(SDL_SHADER_Compiler *compiler, const SDL_SHADER_CompilerParams *params, const char *outfile, FILE *io)
 {
     const SDL_SHADER_CompileData *cd;
     int retval = 0;
 
-    cd = SDL_SHADER_Compile(params);
+    cd = compiler ? SDL_SHADER_CompileWith(compiler, params) : SDL_SHADER_Compile(params);
 
-    if (cd->error_count > 0) {
-        print_errors(cd->errors, cd->error_count);
-    } else {
+    if (!print_errors(cd->errors, cd->error_count)) {
         if (cd->output != NULL) {
             const size_t len = cd->output_len;
             if ((len) && (fwrite(cd->output, len, 1, io) != 1)) {
                 fprintf(stderr, " ... fwrite('%s') failed.\n", outfile);
-            } else if ((outfile != NULL) && (fclose(io) == EOF)) {
+            } else if ((compiler == NULL) && (outfile != NULL) && (fclose(io) == EOF)) {
                 fprintf(stderr, " ... fclose('%s') failed.\n", outfile);
             } else {
                 retval = 1;
@@ -557,11 +766,50 @@ static int compile(const SDL_SHADER_CompilerParams *params, const char *outfile,
         }
     }
 
+    print_memory_stats(&cd->memory);
     SDL_SHADER_FreeCompileData(cd);
 
     return retval;
 }
 
+/* compile each file in turn through one compiler session, appending all the output to (io). */
+static int compile_session(SDL_SHADER_CompilerParams *params, const char **infiles, const int infile_count, const char *outfile, FILE *io)
+{
+    SDL_SHADER_Compiler *compiler = SDL_SHADER_CreateCompiler(params->allocate, params->deallocate, params->allocate_data);
+    int retval = 1;
+    int i;
+
+    if (compiler == NULL) {
+        fail("Out of memory");
+    }
+
+    for (i = 0; i < infile_count; i++) {
+        params->filename = infiles[i];
+        params->source = (const char *) SDL_LoadFile(params->filename, &params->sourcelen);
+        if (params->source == NULL) {
+            fprintf(stderr, "%s: failed to read input file.\n", params->filename);  /* !!! FIXME: pass SDL_GetError(). */
+            retval = 0;
+            continue;
+        }
+
+        if (!compile(compiler, params, outfile, io)) {
+            retval = 0;  /* keep going, so later files show their errors too. */
+        }
+
+        SDL_free((void *) params->source);
+        params->source = NULL;
+    }
+
+    SDL_SHADER_DestroyCompiler(compiler);
+
+    if ((retval) && (outfile != NULL) && (fclose(io) == EOF)) {
+        fprintf(stderr, " ... fclose('%s') failed.\n", outfile);
+        retval = 0;
+    }
+
+    return retval;
+}
+
 typedef enum
 {
     ACTION_UNKNOWN,
@@ -579,6 +827,8 @@ int main(int argc, char **argv)
     int retval = 1;
     const char *outfile = NULL;
     FILE *outio = NULL;
+    const char **infiles = NULL;
+    int infile_count = 0;
     int i;
 
     SDL_zero(params);
@@ -627,6 +877,14 @@ int main(int argc, char **argv)
                 fail("Multiple actions specified");
             }
             action = ACTION_VERSION;
+        } else if (strcmp(arg, "--memory-stats") == 0) {
+            show_memory_stats = SDL_TRUE;
+        } else if (strcmp(arg, "--flat-output") == 0) {
+            flat_output = SDL_TRUE;
+        } else if (strcmp(arg, "--error-columns") == 0) {
+            show_error_columns = SDL_TRUE;
+        } else if (strcmp(arg, "--check-allocator") == 0) {
+            check_allocator = SDL_TRUE;
         } else if (strcmp(arg, "-o") == 0) {
             if (outfile != NULL) {
                 fail("multiple output files specified");
@@ -667,10 +925,11 @@ int main(int argc, char **argv)
             params.defines = defs;
             params.define_count++;
         } else {
-            if (params.filename != NULL) {
-                fail("multiple input files specified");
+            infiles = (const char **) SDL_realloc(infiles, (infile_count + 1) * sizeof (char *));
+            if (infiles == NULL) {
+                fail("Out of memory");
             }
-            params.filename = arg;
+            infiles[infile_count++] = arg;
         }
     }
 
@@ -678,6 +937,13 @@ int main(int argc, char **argv)
         action = ACTION_COMPILE;
     }
 
+    if (check_allocator) {
+        params.allocate = CheckMalloc;
+        params.deallocate = CheckFree;
+        params.reallocate = CheckRealloc;
+        params.sized_deallocate = CheckSizedFree;
+    }
+
 #if 0  /* !!! FIXME */
     if (action == ACTION_VERSION) {
         printf("sdl-shader-compiler, changeset %s\n", "!!! FIXME" /*SDL_SHADER_CHANGESET*/ );
@@ -685,13 +951,18 @@ int main(int argc, char **argv)
     }
 #endif
 
-    if (params.filename == NULL) {
+    if (infile_count == 0) {
         fail("no input file specified");
+    } else if ((infile_count > 1) && (action != ACTION_COMPILE)) {
+        fail("multiple input files specified (only compiling can take more than one)");
     }
 
-    params.source = (const char *) SDL_LoadFile(params.filename, &params.sourcelen);
-    if (params.source == NULL) {
-        fail("failed to read input file");  /* !!! FIXME: need failf, pass SDL_GetError(). */
+    if (infile_count == 1) {
+        params.filename = infiles[0];
+        params.source = (const char *) SDL_LoadFile(params.filename, &params.sourcelen);
+        if (params.source == NULL) {
+            fail("failed to read input file");  /* !!! FIXME: need failf, pass SDL_GetError(). */
+        }
     }
 
     outio = outfile ? fopen(outfile, "wb") : stdout;
@@ -699,12 +970,19 @@ int main(int argc, char **argv)
         fail("failed to open output file");
     }
 
-    if (action == ACTION_PREPROCESS) {
+    if (infile_count > 1) {
+        retval = (!compile_session(&params, infiles, infile_count, outfile, outio));
+    } else if (action == ACTION_PREPROCESS) {
         retval = (!preprocess(&params, outfile, outio));
     } else if (action == ACTION_AST) {
         retval = (!ast(&params, outfile, outio));
     } else if (action == ACTION_COMPILE) {
-        retval = (!compile(&params, outfile, outio));
+        retval = (!compile(NULL, &params, outfile, outio));
+    }
+
+    /* everything the library allocated should be gone by now. */
+    if ((check_allocator) && (!report_allocator_check())) {
+        retval = 1;
     }
 
     if ((retval != 0) && (outfile != NULL)) {
@@ -712,6 +990,7 @@ int main(int argc, char **argv)
     }
 
     SDL_free((void *) params.source);
+    SDL_free(infiles);
 
     for (i = 0; i < params.define_count; i++) {
         SDL_free((void *) params.defines[i].identifier);